@@ -6,7 +6,7 @@
 #include "instructionDecoding.h"
 #include <fstream>
 
-std::bitset<8> readExtraByte(std::ifstream &inputFile) {
+std::bitset<8> readExtraByte(std::istream &inputFile) {
     unsigned char additionalBytes[1];
     inputFile.read(reinterpret_cast<char *>(additionalBytes), 1);
 
@@ -16,7 +16,7 @@ std::bitset<8> readExtraByte(std::ifstream &inputFile) {
     return byteDisplacement;
 }
 
-std::string readExtraBytes(std::ifstream &inputFile, int bytesToRead) {
+std::string readExtraBytes(std::istream &inputFile, int bytesToRead) {
     if (bytesToRead == 0)
         return "";
 
@@ -40,7 +40,7 @@ std::string readExtraBytes(std::ifstream &inputFile, int bytesToRead) {
     return std::to_string(byteDisplacement);
 }
 
-std::string readTwoBytesAndUseMSB(std::ifstream &inputFile, int bytesToRead) {
+std::string readTwoBytesAndUseMSB(std::istream &inputFile, int bytesToRead) {
 
     int byteDisplacement = 0;
     unsigned char additionalBytes[2];
@@ -54,16 +54,16 @@ std::string readTwoBytesAndUseMSB(std::ifstream &inputFile, int bytesToRead) {
     return std::to_string(byteDisplacement);
 }
 
-void readExtraByteAndDoNothing(std::ifstream &inputFile) {
+void readExtraByteAndDoNothing(std::istream &inputFile) {
     unsigned char additionalBytes[1];
     inputFile.read(reinterpret_cast<char*>(additionalBytes), 1);
 }
 
-std::string readDataBytes(std::ifstream &inputFile) {
+std::string readDataBytes(std::istream &inputFile) {
     unsigned char additionalBytes[2];
     inputFile.read(reinterpret_cast<char*>(additionalBytes), 1);
     std::bitset<8> binaryRepresentation(additionalBytes[0]);
-    std::cout << "bits: " << binaryRepresentation << std::endl;
+    //std::cout << "bits: " << binaryRepresentation << std::endl;
     return std::to_string(additionalBytes[0]);
 }
 
@@ -78,6 +78,15 @@ int convertOneByteBase2ToBase10(const std::bitset<8> &secondByte) {
     return result;
 }
 
+int convertOneByteBase2ToSignedBase10(const std::bitset<8> &byte) {
+    // two's complement: MSB (bit 7) weighs -128 instead of +128
+    int result = convertOneByteBase2ToBase10(byte);
+    if (byte[7])
+        result -= 1 << 8;
+
+    return result;
+}
+
 int convertTwoByteBases2ToBase10(const std::bitset<16> &bytes) {
     int result = 0;
     for (size_t i = 0; i < 16; ++i) {
@@ -160,4 +169,21 @@ TwoBytes &getSixteenBits(bool littleEndian, uint16_t twoBytes, std::bitset<16> &
         }
     }
     return sixteenBits;
-}
\ No newline at end of file
+}
+// The decoder always starts with two bytes. The last byte of the image is still returned, with a zero second byte.
+bool readOpcodeBytes(std::istream &inputFile, uint16_t &twoBytes) {
+    twoBytes = 0;
+    inputFile.read(reinterpret_cast<char*>(&twoBytes), sizeof(twoBytes));
+
+    return inputFile.gcount() > 0; // eof stays set when only one byte was left
+}
+
+// One-byte instructions give the second byte back, so the next instruction starts right after them
+void ungetSecondByte(std::istream &inputFile) {
+    if (inputFile.eof()) { // the second byte was never there
+        inputFile.clear();
+        return;
+    }
+
+    inputFile.unget();
+}
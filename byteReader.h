@@ -9,16 +9,19 @@
 #include <vector>
 #include "instructionDecoding.h"
 
-std::string readExtraBytes(std::ifstream &inputFile, int bytesToRead);
-std::string readDataBytes(std::ifstream &inputFile);
-std::bitset<8> readExtraByte(std::ifstream &inputFile);
+std::string readExtraBytes(std::istream &inputFile, int bytesToRead);
+std::string readDataBytes(std::istream &inputFile);
+std::bitset<8> readExtraByte(std::istream &inputFile);
 int convertOneByteBase2ToBase10(const std::bitset<8> &secondByte);
+int convertOneByteBase2ToSignedBase10(const std::bitset<8> &byte);
 int convertTwoByteBases2ToBase10(const std::bitset<16> &bytes);
 std::vector<std::bitset<8>> getJumpInstructionBytes();
 bool checkSixBitsInRegister(const TwoBytes &inputBits, const std::bitset<6> &instructionBits);
 bool checkSevenBitsInRegister(const TwoBytes &inputBits, const std::bitset<7> &instructionBits);
 TwoBytes &getSixteenBits(bool littleEndian, uint16_t twoBytes, std::bitset<16> &binaryTwoBytes, TwoBytes &sixteenBits);
-void readExtraByteAndDoNothing(std::ifstream &inputFile);
-std::string readTwoBytesAndUseMSB(std::ifstream &inputFile, int bytesToRead);
+void readExtraByteAndDoNothing(std::istream &inputFile);
+std::string readTwoBytesAndUseMSB(std::istream &inputFile, int bytesToRead);
+bool readOpcodeBytes(std::istream &inputFile, uint16_t &twoBytes);
+void ungetSecondByte(std::istream &inputFile);
 
 #endif //HW1_BYTEREADER_H
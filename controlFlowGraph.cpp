@@ -0,0 +1,421 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "controlFlowGraph.h"
+#include "instructionDecoding.h"
+#include "byteReader.h"
+#include "extendedDecoding.h"
+
+struct LeaderWorklist {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<int> pending;
+    int activeWorkers = 0;
+};
+
+std::vector<uint8_t> loadBinaryImage(const std::string &listingXAssembledPath) {
+    std::ifstream inputFile(listingXAssembledPath, std::ios::binary);
+    if (!inputFile) {
+        std::cerr << "Could not open file." << std::endl;
+        return {};
+    }
+
+    return {std::istreambuf_iterator<char>(inputFile), std::istreambuf_iterator<char>()};
+}
+
+TwoBytes getTwoBytesAt(const std::vector<uint8_t> &image, int address) {
+    TwoBytes twoBytes{};
+    twoBytes.firstByte = std::bitset<8>(image[address]);
+    if (address + 1 < static_cast<int>(image.size()))
+        twoBytes.secondByte = std::bitset<8>(image[address + 1]);
+    return twoBytes;
+}
+
+// Displacement bytes that follow the mod-reg-r/m byte
+int getModDisplacementLength(const std::bitset<8> &modRegRm) {
+    int mod = static_cast<int>(modRegRm.to_ulong() >> 6);
+    int rm = static_cast<int>(modRegRm.to_ulong() & 0b111);
+
+    if (mod == 0b00)
+        return rm == 0b110 ? 2 : 0; // direct address
+    if (mod == 0b01)
+        return 1;
+    if (mod == 0b10)
+        return 2;
+    return 0;
+}
+
+// Length in bytes of the instruction at 'address' (prefixes included), 0 if it can't be decoded
+int getInstructionLength(const std::vector<uint8_t> &image, int address) {
+    int imageSize = static_cast<int>(image.size());
+    int prefixLength = 0;
+    while (address + prefixLength < imageSize && getOperation(getTwoBytesAt(image, address + prefixLength)) == InstructionPrefix)
+        prefixLength++;
+    if (address + prefixLength >= imageSize)
+        return 0;
+
+    TwoBytes twoBytes = getTwoBytesAt(image, address + prefixLength);
+    int opcode = image[address + prefixLength];
+    int wBit = twoBytes.firstByte[0];
+    int sBit = twoBytes.firstByte[1];
+    int regField = static_cast<int>(twoBytes.secondByte.to_ulong() >> 3) & 0b111;
+    int modRegRmLength = 2 + getModDisplacementLength(twoBytes.secondByte);
+
+    switch (getOperation(twoBytes)) {
+        case MovRegisterToRegister:
+        case AddRegisterToRegister:
+        case SubRegMemoryAndRegToEither:
+        case CmpRegisterMemoryAndRegister:
+        case ArithmeticRegMemoryAndReg:
+        case ShiftRotateInstruction:
+        case SegmentRegisterMove:
+        case LoadAddress:
+        case EscapeInstruction:
+            return prefixLength + modRegRmLength;
+        case Group45Instruction:
+            return isDefinedGroup45(twoBytes) ? prefixLength + modRegRmLength : 0;
+        case MovImmediateToRegister:
+            return prefixLength + 2 + twoBytes.firstByte[3]; // w bit is bit 3 for 1011wreg
+        case AddImmediateToAccumulator:
+        case SubImmediateFromAccumulator:
+        case CmpImmediateWithAccumulator:
+        case ArithmeticImmediateToAccumulator:
+            return prefixLength + 2 + wBit;
+        case XImmediateToRegisterOrMemory:
+            return prefixLength + modRegRmLength + (sBit == 0 && wBit == 1 ? 2 : 1);
+        case MovImmediateToMemory:
+            return prefixLength + modRegRmLength + (wBit == 1 ? 2 : 1);
+        case Group3Instruction: // only test has an immediate
+            return prefixLength + modRegRmLength + (regField <= 1 ? 1 + wBit : 0);
+        case PushPopInstruction:
+            return prefixLength + (opcode == 0x8F ? modRegRmLength : 1);
+        case JumpInstruction:
+            return prefixLength + 2;
+        case MovAccumulatorMemory:
+            return prefixLength + 3;
+        case CallJumpReturn:
+            if (opcode == 0x9A || opcode == 0xEA)
+                return prefixLength + 5; // far: offset, segment
+            if (opcode == 0xE8 || opcode == 0xE9 || opcode == 0xC2 || opcode == 0xCA)
+                return prefixLength + 3;
+            if (opcode == 0xEB || opcode == 0xCD)
+                return prefixLength + 2;
+            return prefixLength + 1;
+        case InputOutput:
+            return prefixLength + (opcode < 0xE8 ? 2 : 1);
+        case NoOperandInstruction:
+            return prefixLength + (opcode == 0xD4 || opcode == 0xD5 ? 2 : 1);
+        case IncDecRegister:
+        case XchgWithAccumulator:
+        case StringInstruction:
+            return prefixLength + 1;
+        default:
+            return 0;
+    }
+}
+
+bool testAndSetBit(AtomicBitmap &bitmap, int index) {
+    uint64_t mask = uint64_t{1} << (index % 64);
+    return bitmap.words[index / 64].fetch_or(mask, std::memory_order_relaxed) & mask;
+}
+
+bool testBit(const AtomicBitmap &bitmap, int index) {
+    uint64_t mask = uint64_t{1} << (index % 64);
+    return bitmap.words[index / 64].load(std::memory_order_relaxed) & mask;
+}
+
+/*
+ * How the instruction at 'address' leaves its block. Conditional jumps and loops keep their fallthrough,
+ * jmp/ret/iret/hlt don't, and int comes back to the next instruction. Far and indirect targets are unknown.
+ */
+BlockExit getBlockExit(const std::vector<uint8_t> &image, int address, int length) {
+    int imageSize = static_cast<int>(image.size());
+    int opcodeAddress = address;
+    while (opcodeAddress < imageSize && getOperation(getTwoBytesAt(image, opcodeAddress)) == InstructionPrefix)
+        opcodeAddress++;
+    if (opcodeAddress >= imageSize)
+        return {};
+
+    TwoBytes twoBytes = getTwoBytesAt(image, opcodeAddress);
+    int opcode = image[opcodeAddress];
+    int regField = static_cast<int>(twoBytes.secondByte.to_ulong() >> 3) & 0b111;
+    int nextAddress = address + length;
+
+    if (getOperation(twoBytes) == JumpInstruction)
+        return {true, true, nextAddress + convertOneByteBase2ToSignedBase10(twoBytes.secondByte)};
+
+    switch (opcode) {
+        case 0xEB: // jmp short
+            return {true, false, nextAddress + convertOneByteBase2ToSignedBase10(twoBytes.secondByte)};
+        case 0xE9: // jmp near
+            if (opcodeAddress + 2 >= imageSize)
+                return {true, false, -1};
+            return {true, false, (nextAddress + static_cast<int16_t>(image[opcodeAddress + 1] | (image[opcodeAddress + 2] << 8))) & 0xffff};
+        case 0xEA: // jmp far
+        case 0xC2: case 0xC3: case 0xCA: case 0xCB: // ret, retf
+        case 0xCF: // iret
+        case 0xF4: // hlt
+            return {true, false, -1};
+        case 0xCC: case 0xCD: case 0xCE: // int3, int, into
+            return {true, true, -1};
+        case 0xFF: // jmp [r/m], jmp far [r/m]
+            if (regField == 4 || regField == 5)
+                return {true, false, -1};
+            return {};
+        default:
+            return {};
+    }
+}
+
+// Decodes from 'leader' until the end of its block. Returns the newly discovered leaders.
+std::vector<int> traceBlock(const std::vector<uint8_t> &image, int leader, AtomicBitmap &leaders, AtomicBitmap &instructionStarts) {
+    std::vector<int> newLeaders;
+    int imageSize = static_cast<int>(image.size());
+    int address = leader;
+
+    auto addLeader = [&](int target) {
+        if (target >= 0 && target < imageSize && !testAndSetBit(leaders, target))
+            newLeaders.push_back(target);
+    };
+
+    while (address < imageSize) {
+        int length = getInstructionLength(image, address);
+        if (length == 0)
+            break;
+        testAndSetBit(instructionStarts, address);
+
+        BlockExit exit = getBlockExit(image, address, length);
+        if (exit.endsBlock) {
+            addLeader(exit.target); // taken
+            if (exit.fallsThrough)
+                addLeader(address + length);
+            break;
+        }
+
+        address += length;
+        if (address < imageSize && testBit(leaders, address))
+            break; // someone else owns the rest
+    }
+
+    return newLeaders;
+}
+
+void drainLeaderWorklist(const std::vector<uint8_t> &image, LeaderWorklist &worklist, AtomicBitmap &leaders, AtomicBitmap &instructionStarts) {
+    while (true) {
+        int leader;
+        {
+            std::unique_lock<std::mutex> lock(worklist.mutex);
+            worklist.condition.wait(lock, [&] { return !worklist.pending.empty() || worklist.activeWorkers == 0; });
+            if (worklist.pending.empty())
+                return; // nothing left and nobody can add more
+            leader = worklist.pending.back();
+            worklist.pending.pop_back();
+            worklist.activeWorkers++;
+        }
+
+        std::vector<int> newLeaders = traceBlock(image, leader, leaders, instructionStarts);
+
+        {
+            std::lock_guard<std::mutex> lock(worklist.mutex);
+            worklist.pending.insert(worklist.pending.end(), newLeaders.begin(), newLeaders.end());
+            worklist.activeWorkers--;
+        }
+        worklist.condition.notify_all();
+    }
+}
+
+// Cooper, Harvey & Kennedy "A Simple, Fast Dominance Algorithm": immediate dominators over reverse postorder
+void computeDominators(ControlFlowGraph &graph) {
+    if (!graph.blocks.contains(graph.entry))
+        return; // nothing decodable at the entry -> no block at all
+
+    std::map<int, int> postorderIndex;
+    std::vector<int> postorder; // block start addresses
+
+    // Iterative DFS from the entry
+    std::vector<std::pair<int, size_t>> stack{{graph.entry, 0}};
+    postorderIndex[graph.entry] = -1;
+    while (!stack.empty()) {
+        auto &[start, nextSuccessor] = stack.back();
+        const std::vector<int> &successors = graph.blocks.at(start).successors;
+        if (nextSuccessor < successors.size()) {
+            int successor = successors[nextSuccessor++];
+            if (!postorderIndex.contains(successor)) {
+                postorderIndex[successor] = -1;
+                stack.emplace_back(successor, 0);
+            }
+            continue;
+        }
+        postorderIndex[start] = static_cast<int>(postorder.size());
+        postorder.push_back(start);
+        stack.pop_back();
+    }
+
+    std::map<int, std::vector<int>> predecessors;
+    for (const auto &[start, block] : graph.blocks)
+        for (int successor : block.successors)
+            predecessors[successor].push_back(start);
+
+    std::vector<int> immediateDominator(postorder.size(), -1); // indexed by postorder index
+    int entryIndex = postorderIndex[graph.entry];
+    immediateDominator[entryIndex] = entryIndex;
+
+    auto intersect = [&](int first, int second) {
+        while (first != second) {
+            while (first < second)
+                first = immediateDominator[first];
+            while (second < first)
+                second = immediateDominator[second];
+        }
+        return first;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = static_cast<int>(postorder.size()) - 1; i >= 0; --i) { // reverse postorder
+            if (i == entryIndex)
+                continue;
+
+            int newDominator = -1;
+            for (int predecessor : predecessors[postorder[i]]) {
+                auto iterator = postorderIndex.find(predecessor);
+                if (iterator == postorderIndex.end() || immediateDominator[iterator->second] == -1)
+                    continue;
+                newDominator = newDominator == -1 ? iterator->second : intersect(iterator->second, newDominator);
+            }
+
+            if (newDominator != immediateDominator[i]) {
+                immediateDominator[i] = newDominator;
+                changed = true;
+            }
+        }
+    }
+
+    // Dominators of a block = its chain of immediate dominators up to the entry
+    for (size_t i = 0; i < postorder.size(); ++i) {
+        std::vector<int> &dominators = graph.blocks.at(postorder[i]).dominators;
+        for (int index = static_cast<int>(i); ; index = immediateDominator[index]) {
+            dominators.push_back(postorder[index]);
+            if (index == entryIndex || immediateDominator[index] == -1)
+                break;
+        }
+        std::sort(dominators.begin(), dominators.end());
+    }
+}
+
+ControlFlowGraph buildControlFlowGraph(const std::vector<uint8_t> &image, int entry, int threadCount) {
+    ControlFlowGraph graph;
+    graph.entry = entry;
+    int imageSize = static_cast<int>(image.size());
+    if (entry < 0 || entry >= imageSize)
+        return graph;
+
+    AtomicBitmap leaders{std::vector<std::atomic<uint64_t>>(imageSize / 64 + 1)};
+    AtomicBitmap instructionStarts{std::vector<std::atomic<uint64_t>>(imageSize / 64 + 1)};
+
+    // 1. Discover every reachable instruction, in parallel
+    LeaderWorklist worklist;
+    testAndSetBit(leaders, entry);
+    worklist.pending.push_back(entry);
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < std::max(1, threadCount); ++i)
+        workers.emplace_back(drainLeaderWorklist, std::cref(image), std::ref(worklist), std::ref(leaders), std::ref(instructionStarts));
+    for (std::thread &worker : workers)
+        worker.join();
+
+    // 2. Every leader starts a block, which runs until the next leader or jump.
+    // Walking from the leaders (and not in address order) keeps overlapping decodings apart.
+    for (int leader = 0; leader < imageSize; ++leader) {
+        if (!testBit(leaders, leader) || !testBit(instructionStarts, leader))
+            continue;
+
+        BasicBlock &block = graph.blocks[leader];
+        block.start = leader;
+        int address = leader;
+        while (true) {
+            block.instructionAddresses.push_back(address);
+            int length = getInstructionLength(image, address);
+            bool endsBlock = getBlockExit(image, address, length).endsBlock;
+            address += length;
+            block.end = address;
+
+            if (endsBlock || address >= imageSize || testBit(leaders, address) || !testBit(instructionStarts, address))
+                break;
+        }
+    }
+
+    // 3. Edges
+    for (auto &[start, block] : graph.blocks) {
+        int last = block.instructionAddresses.back();
+        BlockExit exit = getBlockExit(image, last, block.end - last);
+
+        std::vector<int> targets;
+        if (!exit.endsBlock || exit.fallsThrough)
+            targets.push_back(block.end);
+        if (exit.target != -1)
+            targets.push_back(exit.target);
+
+        for (int target : targets)
+            if (graph.blocks.contains(target) && std::find(block.successors.begin(), block.successors.end(), target) == block.successors.end())
+                block.successors.push_back(target);
+    }
+
+    computeDominators(graph);
+
+    return graph;
+}
+
+const BasicBlock *findBlockContaining(const ControlFlowGraph &graph, int address) {
+    auto iterator = graph.blocks.upper_bound(address);
+    if (iterator == graph.blocks.begin())
+        return nullptr;
+
+    --iterator;
+    if (address >= iterator->second.end)
+        return nullptr;
+    return &iterator->second;
+}
+
+std::string getHexAddress(int address) {
+    std::ostringstream hex;
+    hex << "0x" << std::hex << std::setfill('0') << std::setw(4) << address;
+    return hex.str();
+}
+
+void printControlFlowGraph(const ControlFlowGraph &graph, std::ostream &output) {
+    for (const auto &[start, block] : graph.blocks) {
+        output << "block " << getHexAddress(block.start) << "-" << getHexAddress(block.end)
+               << " (" << block.instructionAddresses.size() << " instructions)" << std::endl;
+
+        output << "  successors :";
+        for (int successor : block.successors)
+            output << " " << getHexAddress(successor);
+
+        output << std::endl << "  dominators :";
+        for (int dominator : block.dominators)
+            output << " " << getHexAddress(dominator);
+        output << std::endl;
+    }
+}
+
+void printControlFlowGraphDot(const ControlFlowGraph &graph, std::ostream &output) {
+    output << "digraph cfg {" << std::endl;
+    for (const auto &[start, block] : graph.blocks) {
+        output << "    \"" << getHexAddress(start) << "\" [shape=box, label=\"" << getHexAddress(block.start)
+               << "-" << getHexAddress(block.end) << "\"];" << std::endl;
+        for (int successor : block.successors)
+            output << "    \"" << getHexAddress(start) << "\" -> \"" << getHexAddress(successor) << "\";" << std::endl;
+    }
+    output << "}" << std::endl;
+}
@@ -0,0 +1,52 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_CONTROLFLOWGRAPH_H
+#define HW1_CONTROLFLOWGRAPH_H
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+struct BasicBlock {
+    int start = 0;
+    int end = 0; // first byte after the block
+    std::vector<int> instructionAddresses;
+    std::vector<int> successors; // start addresses of the successor blocks
+    std::vector<int> dominators; // start addresses, including the block itself
+};
+
+struct ControlFlowGraph {
+    int entry = 0;
+    std::map<int, BasicBlock> blocks; // keyed (and ordered) by start address
+};
+
+struct BlockExit {
+    bool endsBlock = false;
+    bool fallsThrough = true;
+    int target = -1; // direct jump target, -1 -> none or unknown
+};
+
+/*
+ * One bit per byte of the image. testAndSetBit is lock-free, so several threads can mark
+ * block leaders / instruction starts concurrently and only the first one "wins".
+ */
+struct AtomicBitmap {
+    std::vector<std::atomic<uint64_t>> words;
+};
+
+std::vector<uint8_t> loadBinaryImage(const std::string &listingXAssembledPath);
+int getInstructionLength(const std::vector<uint8_t> &image, int address);
+BlockExit getBlockExit(const std::vector<uint8_t> &image, int address, int length);
+bool testAndSetBit(AtomicBitmap &bitmap, int index);
+bool testBit(const AtomicBitmap &bitmap, int index);
+ControlFlowGraph buildControlFlowGraph(const std::vector<uint8_t> &image, int entry, int threadCount);
+const BasicBlock *findBlockContaining(const ControlFlowGraph &graph, int address);
+void printControlFlowGraph(const ControlFlowGraph &graph, std::ostream &output);
+void printControlFlowGraphDot(const ControlFlowGraph &graph, std::ostream &output);
+
+#endif //HW1_CONTROLFLOWGRAPH_H
@@ -0,0 +1,193 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include <iomanip>
+#include <sstream>
+#include <unordered_set>
+
+#include "cppEmitter.h"
+
+std::string getCppLabel(int address) {
+    std::ostringstream label;
+    label << "L_" << std::hex << std::setfill('0') << std::setw(4) << address;
+    return label.str();
+}
+
+bool isWideRegister(const std::string &operand) {
+    return operand.size() == 2 && (operand[1] == 'x' || operand == "sp" || operand == "bp" || operand == "si" || operand == "di");
+}
+
+bool isByteRegister(const std::string &operand) {
+    return operand.size() == 2 && (operand[1] == 'l' || operand[1] == 'h') && std::string("abcd").find(operand[0]) != std::string::npos;
+}
+
+bool isImmediate(const std::string &operand) {
+    return !operand.empty() && std::isdigit(static_cast<unsigned char>(operand[0]));
+}
+
+// ah -> "r.ax >> 8", cl -> "(r.cx & 0xff)", bx -> "r.bx", 12 -> "12"
+std::string getCppReadOperand(const std::string &operand) {
+    if (isWideRegister(operand))
+        return "r." + operand;
+    if (isByteRegister(operand)) {
+        std::string wide = std::string("r.") + operand[0] + "x";
+        return operand[1] == 'h' ? "(" + wide + " >> 8)" : "(" + wide + " & 0xff)";
+    }
+    return operand;
+}
+
+std::string getCppWrite(const std::string &operand, const std::string &value) {
+    if (isWideRegister(operand))
+        return "r." + operand + " = static_cast<uint16_t>(" + value + ");";
+
+    std::string wide = std::string("r.") + operand[0] + "x";
+    return (operand[1] == 'h' ? "setHigh(" : "setLow(") + wide + ", " + value + ");";
+}
+
+std::string getCppJumpCondition(const std::string &jumpName) {
+    if (jumpName == "jnz")
+        return "!r.zeroFlag";
+    if (jumpName == "je")
+        return "r.zeroFlag";
+    if (jumpName == "js")
+        return "r.signFlag";
+    if (jumpName == "jns")
+        return "!r.signFlag";
+    if (jumpName == "loop")
+        return "--r.cx != 0";
+    if (jumpName == "loopz")
+        return "--r.cx != 0 && r.zeroFlag";
+    if (jumpName == "loopnz")
+        return "--r.cx != 0 && !r.zeroFlag";
+    if (jumpName == "jcxz")
+        return "r.cx == 0";
+
+    return ""; // flag not simulated -> never taken, same as the interpreter
+}
+
+// jmp, ret, retf, iret and hlt never continue with the next instruction
+bool isUnconditionalTransfer(const X8086Instruction &instruction) {
+    const std::string &mnemonic = instruction.mnemonic;
+    return mnemonic == "jmp" || mnemonic == "ret" || mnemonic == "retf" || mnemonic == "iret" || mnemonic == "hlt";
+}
+
+void emitCppStatement(const DecodedInstruction &decoded, const std::unordered_set<int> &labels, std::ostream &output) {
+    const X8086Instruction &instruction = decoded.instruction;
+    const std::string &dest = instruction.destReg;
+    const std::string &source = instruction.sourceReg;
+
+    if (instruction.operation == JumpInstruction) {
+        int target = decoded.address + decoded.size + instruction.jumpDisplacement;
+        std::string condition = getCppJumpCondition(instruction.mnemonic);
+        if (condition.empty()) {
+            output << "    // " << instruction.mnemonic << ": condition not simulated, never taken\n";
+            return;
+        }
+
+        output << "    if (" << condition << ") ";
+        if (labels.contains(target))
+            output << "goto " << getCppLabel(target) << ";\n";
+        else
+            output << "return " << target << ";\n";
+        return;
+    }
+
+    if (isUnconditionalTransfer(instruction)) {
+        bool directJump = instruction.operation == CallJumpReturn && instruction.mnemonic == "jmp"
+                          && instruction.sourceReg.find(':') == std::string::npos;
+        int target = (decoded.address + decoded.size + instruction.jumpDisplacement) & 0xffff;
+        if (directJump && labels.contains(target))
+            output << "    goto " << getCppLabel(target) << ";\n";
+        else if (directJump)
+            output << "    return " << target << ";\n";
+        else // target only known at run time
+            output << "    return " << decoded.address << ";\n";
+        return;
+    }
+
+    bool supported = (isWideRegister(dest) || isByteRegister(dest))
+                     && (isWideRegister(source) || isByteRegister(source) || isImmediate(source));
+    if (!supported) {
+        output << "    // not supported (memory operand)\n";
+        return;
+    }
+
+    std::string sourceValue = getCppReadOperand(source);
+    std::string width = isWideRegister(dest) ? "16" : "8";
+
+    if (instruction.mnemonic == "mov") {
+        output << "    " << getCppWrite(dest, sourceValue) << "\n";
+    } else if (instruction.mnemonic == "add" || instruction.mnemonic == "sub" || instruction.mnemonic == "cmp") {
+        std::string sign = instruction.mnemonic == "add" ? " + " : " - ";
+        output << "    result = " << getCppReadOperand(dest) << sign << sourceValue << ";\n"
+               << "    setFlags" << width << "(r, result);\n";
+        if (instruction.mnemonic != "cmp")
+            output << "    " << getCppWrite(dest, "result") << "\n";
+    } else {
+        output << "    // not supported: " << instruction.mnemonic << "\n";
+    }
+}
+
+void emitCppSource(const std::vector<DecodedInstruction> &decodedInstructions, const std::string &sourceName,
+                   std::ostream &output) {
+    std::unordered_set<int> labels;
+    for (const DecodedInstruction &decoded : decodedInstructions)
+        labels.insert(decoded.address);
+
+    int endAddress = decodedInstructions.empty() ? 0 : decodedInstructions.back().address + decodedInstructions.back().size;
+
+    output << "// Generated by hw1 --emit-cpp from " << sourceName << "\n"
+           << "#include <cstdint>\n"
+           << "#include <cstdio>\n\n"
+           << "struct Registers {\n"
+           << "    uint16_t ax = 0, bx = 0, cx = 0, dx = 0, sp = 0, bp = 0, si = 0, di = 0;\n"
+           << "    bool zeroFlag = false;\n"
+           << "    bool signFlag = false;\n"
+           << "};\n\n"
+           << "[[maybe_unused]] static void setLow(uint16_t &reg, int value) { reg = (reg & 0xff00) | (value & 0xff); }\n"
+           << "[[maybe_unused]] static void setHigh(uint16_t &reg, int value) { reg = (reg & 0x00ff) | ((value & 0xff) << 8); }\n"
+           << "[[maybe_unused]] static void setFlags16(Registers &r, int value) { r.zeroFlag = (value & 0xffff) == 0; r.signFlag = (value >> 15) & 1; }\n"
+           << "[[maybe_unused]] static void setFlags8(Registers &r, int value) { r.zeroFlag = (value & 0xff) == 0; r.signFlag = (value >> 7) & 1; }\n\n"
+           << "// Runs from 'entry' until the end of the image or a jump outside of it. Returns the final IP.\n"
+           << "static int run(Registers &r, int entry) {\n"
+           << "    int result = 0;\n"
+           << "    switch (entry) {\n";
+
+    for (const DecodedInstruction &decoded : decodedInstructions)
+        output << "        case " << decoded.address << ": goto " << getCppLabel(decoded.address) << ";\n";
+
+    output << "        default: return entry;\n"
+           << "    }\n";
+
+    for (size_t i = 0; i < decodedInstructions.size(); ++i) {
+        const DecodedInstruction &decoded = decodedInstructions[i];
+        const X8086Instruction &instruction = decoded.instruction;
+        output << getCppLabel(decoded.address) << ": // " << instruction.mnemonic << " ";
+        if (!instruction.destReg.empty())
+            output << instruction.destReg << ", ";
+        output << instruction.sourceReg << "\n";
+        emitCppStatement(decoded, labels, output);
+
+        // Next statement isn't the next instruction (gap or overlapping decoding) -> explicit fallthrough
+        int nextAddress = decoded.address + decoded.size;
+        if (i + 1 < decodedInstructions.size() && decodedInstructions[i + 1].address != nextAddress
+            && !isUnconditionalTransfer(instruction)) {
+            if (labels.contains(nextAddress))
+                output << "    goto " << getCppLabel(nextAddress) << ";\n";
+            else
+                output << "    return " << nextAddress << ";\n";
+        }
+    }
+
+    output << "    (void) result;\n"
+           << "    return " << endAddress << ";\n"
+           << "}\n\n"
+           << "int main() {\n"
+           << "    Registers r;\n"
+           << "    int ip = run(r, 0);\n"
+           << "    std::printf(\"ax: 0x%04x\\nbx: 0x%04x\\ncx: 0x%04x\\ndx: 0x%04x\\n\", r.ax, r.bx, r.cx, r.dx);\n"
+           << "    std::printf(\"sp: 0x%04x\\nbp: 0x%04x\\nsi: 0x%04x\\ndi: 0x%04x\\n\", r.sp, r.bp, r.si, r.di);\n"
+           << "    std::printf(\"Z -> %d | S -> %d\\nIP : 0x%04x\\n\", r.zeroFlag, r.signFlag, ip);\n"
+           << "}\n";
+}
@@ -0,0 +1,22 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_CPPEMITTER_H
+#define HW1_CPPEMITTER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "instructionDecoding.h"
+
+/*
+ * Static recompilation: every decoded instruction becomes a labelled C++ statement working on a register struct.
+ * Jumps become 'goto', and a switch on the entry address handles dynamic targets.
+ * The instructions are sorted by address but don't have to be contiguous (blocks of the CFG, with data in between).
+ */
+void emitCppSource(const std::vector<DecodedInstruction> &decodedInstructions, const std::string &sourceName,
+                   std::ostream &output);
+
+#endif //HW1_CPPEMITTER_H
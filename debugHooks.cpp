@@ -0,0 +1,137 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+#include "debugHooks.h"
+
+// Decimal or 0x-prefixed hexadecimal, the whole text has to be a number
+bool parseWatchNumber(const std::string &text, int &value) {
+    bool hexadecimal = text.starts_with("0x") || text.starts_with("0X");
+    const char *first = text.data() + (hexadecimal ? 2 : 0);
+    const char *last = text.data() + text.size();
+    auto [end, error] = std::from_chars(first, last, value, hexadecimal ? 16 : 10);
+
+    return first != last && error == std::errc() && end == last;
+}
+
+// address is an IP in the code segment, e.g. "0x6"
+bool addBreakpoint(BreakpointPolicy &policy, const std::string &address) {
+    int ip = 0;
+    if (!parseWatchNumber(address, ip) || ip < 0 || ip > 0xffff) {
+        std::cerr << "Invalid breakpoint (expected an address up to 0xffff) : " << address << std::endl;
+        return false;
+    }
+
+    policy.ipBreakpoints[ip] = true;
+    return true;
+}
+
+// condition is "<register>=<value>", e.g. "cx=0". Only the word registers are simulated.
+bool addRegisterWatchpoint(BreakpointPolicy &policy, const std::string &condition) {
+    static const std::vector<std::string> wordRegisters{"ax", "bx", "cx", "dx", "sp", "bp", "si", "di"};
+
+    auto pos = condition.find('=');
+    RegisterWatchpoint watchpoint;
+    if (pos == std::string::npos || !parseWatchNumber(condition.substr(pos + 1), watchpoint.value)) {
+        std::cerr << "Invalid watchpoint (expected reg=value) : " << condition << std::endl;
+        return false;
+    }
+
+    watchpoint.registerName = condition.substr(0, pos);
+    if (std::find(wordRegisters.begin(), wordRegisters.end(), watchpoint.registerName) == wordRegisters.end()) {
+        std::cerr << "Invalid watchpoint (register is one of ax, bx, cx, dx, sp, bp, si, di) : " << condition << std::endl;
+        return false;
+    }
+
+    watchpoint.value &= 0xffff;
+    watchpoint.wasMatching = watchpoint.value == 0; // registers start at 0
+    policy.registerWatchpoints.push_back(watchpoint);
+    return true;
+}
+
+// range is "<address>" or "<first>-<last>" (inclusive), e.g. "0x1000-0x100f"
+bool addMemoryWatchpoint(BreakpointPolicy &policy, const std::string &range) {
+    auto pos = range.find('-');
+    MemoryWatchpoint watchpoint;
+    bool valid = parseWatchNumber(range.substr(0, pos), watchpoint.firstAddress);
+    watchpoint.lastAddress = watchpoint.firstAddress;
+    if (valid && pos != std::string::npos)
+        valid = parseWatchNumber(range.substr(pos + 1), watchpoint.lastAddress);
+
+    if (!valid || watchpoint.firstAddress > watchpoint.lastAddress || watchpoint.lastAddress > 0xffff) {
+        std::cerr << "Invalid memory watchpoint (expected address or first-last, up to 0xffff) : " << range << std::endl;
+        return false;
+    }
+
+    for (int page = watchpoint.firstAddress >> watchPageShift; page <= watchpoint.lastAddress >> watchPageShift; ++page)
+        policy.watchedPages.set(page);
+    policy.memoryWatchpoints.push_back(watchpoint);
+    return true;
+}
+
+bool hasBreakpointsOrWatchpoints(const BreakpointPolicy &policy) {
+    if (!policy.registerWatchpoints.empty() || !policy.memoryWatchpoints.empty())
+        return true;
+
+    for (bool breakpoint : policy.ipBreakpoints)
+        if (breakpoint)
+            return true;
+
+    return false;
+}
+
+bool checkBreakpoint(const BreakpointPolicy &policy, int ip) {
+    return policy.ipBreakpoints[ip & 0xffff];
+}
+
+bool checkRegisterWatchpoints(BreakpointPolicy &policy, ProgramOutput &programOutput, std::string &stopReason) {
+    bool hit = false;
+    for (RegisterWatchpoint &watchpoint : policy.registerWatchpoints) {
+        bool matching = (programOutput.registerValueMap.at(watchpoint.registerName) & 0xffff) == watchpoint.value;
+        if (matching && !watchpoint.wasMatching) {
+            stopReason = "Watchpoint : " + watchpoint.registerName + " became " + std::to_string(watchpoint.value);
+            hit = true;
+        }
+        watchpoint.wasMatching = matching;
+    }
+
+    return hit;
+}
+
+// Slow path, the store is on a watched page
+bool findMemoryWatchpoint(const BreakpointPolicy &policy, int address, int width, std::string &stopReason) {
+    int firstAddress = address & 0xffff;
+    int lastAddress = firstAddress + width - 1;
+
+    for (const MemoryWatchpoint &watchpoint : policy.memoryWatchpoints) {
+        if (firstAddress <= watchpoint.lastAddress && lastAddress >= watchpoint.firstAddress) {
+            stopReason = "Watchpoint : store of " + std::to_string(width) + " bytes to [" + std::to_string(firstAddress) + "]";
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Returns the instruction countdown for the run loop
+long long startRunBudget(RunBudget &budget) {
+    budget.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(budget.timeoutMs);
+    budget.blocksUntilClockCheck = runBudgetClockInterval;
+    budget.exhausted = false;
+
+    return budget.maxInstructions > 0 ? budget.maxInstructions : std::numeric_limits<long long>::max();
+}
+
+bool checkRunDeadline(RunBudget &budget, std::string &stopReason) {
+    budget.blocksUntilClockCheck = runBudgetClockInterval;
+    if (std::chrono::steady_clock::now() < budget.deadline)
+        return false;
+
+    budget.exhausted = true;
+    stopReason = "Timeout : " + std::to_string(budget.timeoutMs) + " ms";
+    return true;
+}
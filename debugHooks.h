@@ -0,0 +1,93 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_DEBUGHOOKS_H
+#define HW1_DEBUGHOOKS_H
+
+#include <bitset>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "instructionDecoding.h"
+
+/*
+ * The execution loop is templated on one of these policies.
+ * With NoDebugPolicy every hook is discarded at compile time -> same code as without debugging.
+ */
+struct NoDebugPolicy {
+    static constexpr bool enabled = false;
+};
+
+struct RegisterWatchpoint {
+    std::string registerName;
+    int value = 0;
+    bool wasMatching = false; // only stop when the register *becomes* the value
+};
+
+// Stores into [firstAddress, lastAddress]
+struct MemoryWatchpoint {
+    int firstAddress = 0;
+    int lastAddress = 0;
+};
+
+// Pages of 256 bytes that hold at least one watched address: stores elsewhere only cost the bitmap test
+const int watchPageShift = 8;
+const int watchPageCount = 0x10000 >> watchPageShift;
+
+struct BreakpointPolicy {
+    static constexpr bool enabled = true;
+    std::vector<bool> ipBreakpoints = std::vector<bool>(1 << 16); // one bit per address in the code segment
+    std::vector<RegisterWatchpoint> registerWatchpoints;
+    std::vector<MemoryWatchpoint> memoryWatchpoints;
+    std::bitset<watchPageCount> watchedPages;
+};
+
+/*
+ * Run budget for guest programs that may never stop. Only checked at the end of a basic block (after a jump):
+ * the loop keeps a local countdown of instructions, and the clock is read once every runBudgetClockInterval blocks.
+ */
+const int runBudgetClockInterval = 1024;
+
+struct RunBudget {
+    long long maxInstructions = 0; // 0 -> no limit
+    int timeoutMs = 0; // 0 -> no limit
+    std::chrono::steady_clock::time_point deadline;
+    int blocksUntilClockCheck = runBudgetClockInterval;
+    bool exhausted = false;
+};
+
+bool addBreakpoint(BreakpointPolicy &policy, const std::string &address);
+bool addRegisterWatchpoint(BreakpointPolicy &policy, const std::string &condition);
+bool addMemoryWatchpoint(BreakpointPolicy &policy, const std::string &range);
+bool hasBreakpointsOrWatchpoints(const BreakpointPolicy &policy);
+bool checkBreakpoint(const BreakpointPolicy &policy, int ip);
+bool checkRegisterWatchpoints(BreakpointPolicy &policy, ProgramOutput &programOutput, std::string &stopReason);
+bool findMemoryWatchpoint(const BreakpointPolicy &policy, int address, int width, std::string &stopReason);
+
+// Called for every guest store when the loop runs with BreakpointPolicy
+inline bool checkMemoryWatchpoints(const BreakpointPolicy &policy, int address, int width, std::string &stopReason) {
+    int lastAddress = (address + width - 1) & 0xffff;
+    if (!policy.watchedPages.test((address & 0xffff) >> watchPageShift) && !policy.watchedPages.test(lastAddress >> watchPageShift)) [[likely]]
+        return false;
+
+    return findMemoryWatchpoint(policy, address, width, stopReason);
+}
+long long startRunBudget(RunBudget &budget);
+bool checkRunDeadline(RunBudget &budget, std::string &stopReason);
+
+// Called at block boundaries only
+inline bool checkRunBudget(RunBudget &budget, long long instructionCountdown, std::string &stopReason) {
+    if (instructionCountdown <= 0) [[unlikely]] {
+        budget.exhausted = true;
+        stopReason = "Instruction budget : " + std::to_string(budget.maxInstructions - instructionCountdown) + " instructions";
+        return true;
+    }
+    if (budget.timeoutMs > 0 && --budget.blocksUntilClockCheck == 0)
+        return checkRunDeadline(budget, stopReason);
+
+    return false;
+}
+
+#endif //HW1_DEBUGHOOKS_H
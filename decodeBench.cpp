@@ -0,0 +1,83 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+#include "decodeBench.h"
+#include "instructionDecoding.h"
+#include "byteReader.h"
+#include "registerState.h"
+
+// The families that were already decoded come first: broader coverage must not slow them down
+std::vector<DecodeBenchCase> getDecodeBenchCases() {
+    return {
+            {"mov r/m, reg",     {{0x89, 0xD9}, {0x8B, 0x40, 0x10}, {0x89, 0x87, 0x00, 0x10}, {0x89, 0x46, 0x02}}},
+            {"mov reg, imm",     {{0xB9, 0x03, 0x00}, {0xB1, 0x05}}},
+            {"add/sub/cmp",      {{0x01, 0xD8}, {0x29, 0xCB}, {0x39, 0xE5}, {0x05, 0x10, 0x00}, {0x83, 0xC1, 0x05}, {0x83, 0x46, 0x02, 0x05}}},
+            {"conditional jump", {{0x75, 0x00}, {0x74, 0x00}, {0x78, 0x00}}},
+            {"or/and/xor/test",  {{0x31, 0xC0}, {0x09, 0x07}, {0x25, 0xFF, 0x00}, {0x84, 0xC3}, {0x81, 0xE3, 0xFF, 0x00}}},
+            {"push/pop",         {{0x50}, {0x5B}, {0x1E}, {0x1F}, {0xFF, 0x37}, {0x8F, 0x07}}},
+            {"inc/dec/xchg",     {{0x41}, {0x4A}, {0x91}, {0x90}, {0xFE, 0x07}}},
+            {"shift/rotate",     {{0xD1, 0xE0}, {0xD3, 0xE8}, {0xD0, 0x47, 0x02}}},
+            {"mul/div/not/neg",  {{0xF7, 0xE3}, {0xF6, 0xF1}, {0xF7, 0xD0}, {0xF7, 0x07, 0x01, 0x00}}},
+            {"string",           {{0xA4}, {0xA5}, {0xAA}, {0xAD}, {0xAE}}},
+            {"prefixes",         {{0xF3, 0xA5}, {0xF2, 0xAE}, {0x26, 0x8B, 0x07}, {0xF0, 0x86, 0x07}}},
+            {"call/jmp/ret",     {{0xE8, 0x00, 0x00}, {0xEB, 0x00}, {0xE9, 0x00, 0x00}, {0xFF, 0xD3}, {0xC3}, {0xC2, 0x04, 0x00}}},
+            {"segment registers", {{0x8E, 0xD8}, {0x8C, 0xC0}, {0xC4, 0x1F}, {0x8D, 0x40, 0x10}}},
+            {"mov memory",       {{0xA1, 0x00, 0x10}, {0xA2, 0x00, 0x10}, {0xC7, 0x06, 0x00, 0x10, 0x34, 0x12}, {0xC7, 0x86, 0x34, 0x12, 0x78, 0x56}}},
+            {"misc",             {{0xFC}, {0x9C}, {0x98}, {0xE4, 0x60}, {0xEE}, {0xD4, 0x0A}, {0xCD, 0x21}, {0xD9, 0x07}}}
+    };
+}
+
+// Decodes 'instructionCount' instructions of each family through the interpreter entry point.
+// Returns false if a family loses sync, i.e. doesn't consume exactly the bytes of its encodings.
+bool runDecodeBenchmark(int instructionCount, std::ostream &output) {
+    bool inSync = true;
+    output << std::left << std::setw(20) << "family" << std::right << std::setw(12) << "ns/instr"
+           << std::setw(14) << "Minstr/s" << std::endl;
+
+    for (const DecodeBenchCase &benchCase : getDecodeBenchCases()) {
+        std::string image;
+        int expectedInstructions = 0;
+        while (expectedInstructions < instructionCount) {
+            for (const std::vector<uint8_t> &encoding : benchCase.encodings)
+                image.append(encoding.begin(), encoding.end());
+            expectedInstructions += static_cast<int>(benchCase.encodings.size());
+        }
+
+        std::istringstream input(image);
+        ProgramOutput scratch;
+        scratch.registerValueMap = initializeRegisterValueMap();
+        uint16_t twoBytes;
+        std::bitset<16> binaryTwoBytes;
+        TwoBytes sixteenBits{};
+        int decodedInstructions = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        while (readOpcodeBytes(input, twoBytes)) {
+            X8086Instruction instruction{};
+            InstructionPointer ip{};
+            getSixteenBits(true, twoBytes, binaryTwoBytes, sixteenBits);
+            executeOperation(sixteenBits, input, instruction, scratch, ip);
+            if (instruction.operation == NotFound)
+                break;
+            decodedInstructions++;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double nanosecondsPerInstruction = seconds * 1e9 / std::max(decodedInstructions, 1);
+        output << std::left << std::setw(20) << benchCase.family << std::right << std::fixed << std::setprecision(1)
+               << std::setw(12) << nanosecondsPerInstruction
+               << std::setw(14) << decodedInstructions / seconds / 1e6;
+        if (decodedInstructions != expectedInstructions) {
+            output << "   out of sync after " << decodedInstructions << " instructions";
+            inSync = false;
+        }
+        output << std::defaultfloat << std::endl;
+    }
+
+    return inSync;
+}
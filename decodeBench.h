@@ -0,0 +1,22 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_DECODEBENCH_H
+#define HW1_DECODEBENCH_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// One opcode family, and a few encodings of it that get repeated to fill the benchmark image
+struct DecodeBenchCase {
+    std::string family;
+    std::vector<std::vector<uint8_t>> encodings;
+};
+
+std::vector<DecodeBenchCase> getDecodeBenchCases();
+bool runDecodeBenchmark(int instructionCount, std::ostream &output);
+
+#endif //HW1_DECODEBENCH_H
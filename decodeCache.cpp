@@ -0,0 +1,147 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "decodeCache.h"
+
+const char decodeCacheMagic[8] = {'H', 'W', '1', 'D', 'C', 'A', 'C', 'H'};
+
+// FNV-1a, 64 bits
+uint64_t hashBytes(const void *data, size_t size, uint64_t hash) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+std::string getDecodeCachePath(const std::string &cacheDirectory, uint64_t contentHash, DecodeCacheKind kind) {
+    std::ostringstream path;
+    path << cacheDirectory << "/" << std::hex << std::setfill('0') << std::setw(16) << contentHash
+         << (kind == ReachableBlocksDecode ? ".cfg.hw1dc" : ".hw1dc");
+    return path.str();
+}
+
+DecodeCacheRecord makeDecodeCacheRecord(const DecodedInstruction &decoded) {
+    const X8086Instruction &instruction = decoded.instruction;
+    DecodeCacheRecord record{};
+    record.text = makeInstructionRecord(decoded.address, instruction);
+    record.size = decoded.size;
+    record.operation = instruction.operation;
+    record.wBit = instruction.wBit;
+    record.dBit = instruction.dBit;
+    record.jumpDisplacement = instruction.jumpDisplacement;
+    record.effectiveAddressForm = instruction.effectiveAddressForm;
+    record.displacement = instruction.displacement;
+
+    return record;
+}
+
+DecodedInstruction getDecodedInstructionFromRecord(const DecodeCacheRecord &record) {
+    DecodedInstruction decoded;
+    decoded.address = record.text.address;
+    decoded.size = record.size;
+    decoded.instruction = getInstructionFromRecord(record.text);
+    decoded.instruction.operation = static_cast<OperationName>(record.operation);
+    decoded.instruction.wBit = record.wBit;
+    decoded.instruction.dBit = record.dBit;
+    decoded.instruction.jumpDisplacement = record.jumpDisplacement;
+    decoded.instruction.effectiveAddressForm = record.effectiveAddressForm;
+    decoded.instruction.displacement = record.displacement;
+
+    return decoded;
+}
+
+bool loadDecodeCache(const std::string &path, uint64_t contentHash, uint64_t imageSize, std::vector<DecodedInstruction> &decodedInstructions) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < static_cast<off_t>(sizeof(DecodeCacheHeader))) {
+        close(fd);
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(fileStat.st_size);
+    void *mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    const auto *header = static_cast<const DecodeCacheHeader *>(mapping);
+    const auto *boundaries = reinterpret_cast<const uint32_t *>(header + 1);
+    size_t boundariesSize = (header->recordCount * sizeof(uint32_t) + 7) / 8 * 8;
+    const auto *records = reinterpret_cast<const DecodeCacheRecord *>(reinterpret_cast<const char *>(boundaries) + boundariesSize);
+    size_t payloadSize = boundariesSize + header->recordCount * sizeof(DecodeCacheRecord);
+
+    bool valid = std::memcmp(header->magic, decodeCacheMagic, sizeof(decodeCacheMagic)) == 0
+                 && header->formatVersion == decodeCacheFormatVersion
+                 && header->decoderVersion == decoderVersion
+                 && header->contentHash == contentHash
+                 && header->imageSize == imageSize
+                 && sizeof(DecodeCacheHeader) + payloadSize == fileSize
+                 && header->checksum == hashBytes(boundaries, payloadSize);
+
+    if (valid) {
+        decodedInstructions.clear();
+        decodedInstructions.reserve(header->recordCount);
+        for (uint64_t i = 0; i < header->recordCount; ++i)
+            decodedInstructions.push_back(getDecodedInstructionFromRecord(records[i]));
+    }
+
+    munmap(mapping, fileSize);
+    return valid;
+}
+
+bool writeDecodeCache(const std::string &path, uint64_t contentHash, uint64_t imageSize, const std::vector<DecodedInstruction> &decodedInstructions) {
+    size_t boundariesSize = (decodedInstructions.size() * sizeof(uint32_t) + 7) / 8 * 8;
+    std::vector<char> payload(boundariesSize + decodedInstructions.size() * sizeof(DecodeCacheRecord), 0);
+
+    auto *boundaries = reinterpret_cast<uint32_t *>(payload.data());
+    auto *records = reinterpret_cast<DecodeCacheRecord *>(payload.data() + boundariesSize);
+    for (size_t i = 0; i < decodedInstructions.size(); ++i) {
+        boundaries[i] = static_cast<uint32_t>(decodedInstructions[i].address);
+        records[i] = makeDecodeCacheRecord(decodedInstructions[i]);
+    }
+
+    DecodeCacheHeader header{};
+    std::memcpy(header.magic, decodeCacheMagic, sizeof(decodeCacheMagic));
+    header.formatVersion = decodeCacheFormatVersion;
+    header.decoderVersion = decoderVersion;
+    header.contentHash = contentHash;
+    header.imageSize = imageSize;
+    header.recordCount = decodedInstructions.size();
+    header.checksum = hashBytes(payload.data(), payload.size());
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+    // Write next to the final file and rename, so a concurrent reader never sees half a file
+    std::string temporaryPath = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!output)
+            return false;
+        output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        output.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        if (!output)
+            return false;
+    }
+
+    std::filesystem::rename(temporaryPath, path, error);
+    return !error;
+}
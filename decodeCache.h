@@ -0,0 +1,61 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_DECODECACHE_H
+#define HW1_DECODECACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "instructionDecoding.h"
+#include "instructionPipeline.h"
+
+/*
+ * On-disk cache of a decoding, one file per image and kind: <cache dir>/<content hash>.hw1dc for the linear sweep,
+ * <content hash>.cfg.hw1dc for the blocks reachable from address 0
+ *
+ * Layout (native endianness, everything 8-byte aligned so the file can be used straight from mmap):
+ *   DecodeCacheHeader
+ *   uint32_t boundaries[recordCount]   -> address of every instruction, ascending
+ *   DecodeCacheRecord records[recordCount]
+ *
+ * A file is rejected (and rewritten) when the magic, format version, decoder version, image hash/size
+ * or checksum don't match.
+ */
+const uint32_t decodeCacheFormatVersion = 2;
+
+enum DecodeCacheKind {
+    LinearSweepDecode,
+    ReachableBlocksDecode,
+};
+
+struct DecodeCacheHeader {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t decoderVersion;
+    uint64_t contentHash;
+    uint64_t imageSize;
+    uint64_t recordCount;
+    uint64_t checksum; // over boundaries + records
+};
+
+struct DecodeCacheRecord {
+    InstructionRecord text;
+    int32_t size;
+    int32_t operation;
+    int32_t wBit;
+    int32_t dBit;
+    int32_t jumpDisplacement;
+    int32_t effectiveAddressForm;
+    int32_t displacement;
+    int32_t padding;
+};
+
+uint64_t hashBytes(const void *data, size_t size, uint64_t hash = 14695981039346656037ull);
+std::string getDecodeCachePath(const std::string &cacheDirectory, uint64_t contentHash, DecodeCacheKind kind);
+bool loadDecodeCache(const std::string &path, uint64_t contentHash, uint64_t imageSize, std::vector<DecodedInstruction> &decodedInstructions);
+bool writeDecodeCache(const std::string &path, uint64_t contentHash, uint64_t imageSize, const std::vector<DecodedInstruction> &decodedInstructions);
+
+#endif //HW1_DECODECACHE_H
@@ -54,14 +54,12 @@ std::unordered_map<std::bitset<3>, std::string, BitsetHash> getHashEffAddCalcula
     result[std::bitset<3>("110")] = "[bp]";
     result[std::bitset<3>("111")] = "[bx]";
 
-    // Add 8 or 16 bit displacement
+    // Add 8 or 16 bit displacement, [bp] included: the direct address (MOD 00, r/m 110) is decoded by the callers
     if (operationMod == MemoryMode8Bit || operationMod == MemoryMode16Bit) {
         for (auto &[key, value]: result) {
-            if (value != "[bp]") {
-                auto pos = value.find_last_of(']');
-                if (pos != std::string::npos) { // make sure object was found
-                    value.insert(pos, " + " + bitDisplacement);
-                }
+            auto pos = value.find_last_of(']');
+            if (pos != std::string::npos) { // make sure object was found
+                value.insert(pos, " + " + bitDisplacement);
             }
         }
     }
@@ -100,8 +98,131 @@ std::unordered_map<std::bitset<3>, std::string, BitsetHash> getHashAddSubCmpType
     std::unordered_map<std::bitset<3>, std::string, BitsetHash> result;
 
     result[std::bitset<3>("000")] = "add";
+    result[std::bitset<3>("001")] = "or";
+    result[std::bitset<3>("010")] = "adc";
+    result[std::bitset<3>("011")] = "sbb";
+    result[std::bitset<3>("100")] = "and";
     result[std::bitset<3>("101")] = "sub";
+    result[std::bitset<3>("110")] = "xor";
     result[std::bitset<3>("111")] = "cmp";
 
+    return result;
+}
+
+// reg field of D0 to D3
+std::unordered_map<std::bitset<3>, std::string, BitsetHash> getHashShiftRotateEncoding() {
+    std::unordered_map<std::bitset<3>, std::string, BitsetHash> result;
+
+    result[std::bitset<3>("000")] = "rol";
+    result[std::bitset<3>("001")] = "ror";
+    result[std::bitset<3>("010")] = "rcl";
+    result[std::bitset<3>("011")] = "rcr";
+    result[std::bitset<3>("100")] = "shl";
+    result[std::bitset<3>("101")] = "shr";
+    result[std::bitset<3>("110")] = "shl"; // undocumented alias
+    result[std::bitset<3>("111")] = "sar";
+
+    return result;
+}
+
+// reg field of F6 and F7
+std::unordered_map<std::bitset<3>, std::string, BitsetHash> getHashGroup3Encoding() {
+    std::unordered_map<std::bitset<3>, std::string, BitsetHash> result;
+
+    result[std::bitset<3>("000")] = "test";
+    result[std::bitset<3>("001")] = "test"; // undocumented alias
+    result[std::bitset<3>("010")] = "not";
+    result[std::bitset<3>("011")] = "neg";
+    result[std::bitset<3>("100")] = "mul";
+    result[std::bitset<3>("101")] = "imul";
+    result[std::bitset<3>("110")] = "div";
+    result[std::bitset<3>("111")] = "idiv";
+
+    return result;
+}
+
+// reg field of FE (inc and dec only) and FF
+std::unordered_map<std::bitset<3>, std::string, BitsetHash> getHashGroup45Encoding() {
+    std::unordered_map<std::bitset<3>, std::string, BitsetHash> result;
+
+    result[std::bitset<3>("000")] = "inc";
+    result[std::bitset<3>("001")] = "dec";
+    result[std::bitset<3>("010")] = "call";
+    result[std::bitset<3>("011")] = "call"; // far
+    result[std::bitset<3>("100")] = "jmp";
+    result[std::bitset<3>("101")] = "jmp"; // far
+    result[std::bitset<3>("110")] = "push";
+
+    return result;
+}
+
+std::unordered_map<std::bitset<2>, std::string, BitsetHash> getHashSegmentRegisterEncoding() {
+    std::unordered_map<std::bitset<2>, std::string, BitsetHash> result;
+
+    result[std::bitset<2>("00")] = "es";
+    result[std::bitset<2>("01")] = "cs";
+    result[std::bitset<2>("10")] = "ss";
+    result[std::bitset<2>("11")] = "ds";
+
+    return result;
+}
+
+// Instructions without operands (string instructions included)
+std::unordered_map<std::bitset<8>, std::string, BitsetHash> getHashSingleByteEncoding() {
+    std::unordered_map<std::bitset<8>, std::string, BitsetHash> result;
+
+    result[std::bitset<8>("00100111")] = "daa";
+    result[std::bitset<8>("00101111")] = "das";
+    result[std::bitset<8>("00110111")] = "aaa";
+    result[std::bitset<8>("00111111")] = "aas";
+    result[std::bitset<8>("10010000")] = "nop";
+    result[std::bitset<8>("10011000")] = "cbw";
+    result[std::bitset<8>("10011001")] = "cwd";
+    result[std::bitset<8>("10011011")] = "wait";
+    result[std::bitset<8>("10011100")] = "pushf";
+    result[std::bitset<8>("10011101")] = "popf";
+    result[std::bitset<8>("10011110")] = "sahf";
+    result[std::bitset<8>("10011111")] = "lahf";
+    result[std::bitset<8>("10100100")] = "movsb";
+    result[std::bitset<8>("10100101")] = "movsw";
+    result[std::bitset<8>("10100110")] = "cmpsb";
+    result[std::bitset<8>("10100111")] = "cmpsw";
+    result[std::bitset<8>("10101010")] = "stosb";
+    result[std::bitset<8>("10101011")] = "stosw";
+    result[std::bitset<8>("10101100")] = "lodsb";
+    result[std::bitset<8>("10101101")] = "lodsw";
+    result[std::bitset<8>("10101110")] = "scasb";
+    result[std::bitset<8>("10101111")] = "scasw";
+    result[std::bitset<8>("11000011")] = "ret";
+    result[std::bitset<8>("11001011")] = "retf";
+    result[std::bitset<8>("11001100")] = "int3";
+    result[std::bitset<8>("11001110")] = "into";
+    result[std::bitset<8>("11001111")] = "iret";
+    result[std::bitset<8>("11010100")] = "aam";
+    result[std::bitset<8>("11010101")] = "aad";
+    result[std::bitset<8>("11010111")] = "xlat";
+    result[std::bitset<8>("11110100")] = "hlt";
+    result[std::bitset<8>("11110101")] = "cmc";
+    result[std::bitset<8>("11111000")] = "clc";
+    result[std::bitset<8>("11111001")] = "stc";
+    result[std::bitset<8>("11111010")] = "cli";
+    result[std::bitset<8>("11111011")] = "sti";
+    result[std::bitset<8>("11111100")] = "cld";
+    result[std::bitset<8>("11111101")] = "std";
+
+    return result;
+}
+
+std::unordered_map<std::bitset<8>, std::string, BitsetHash> getHashPrefixEncoding() {
+    std::unordered_map<std::bitset<8>, std::string, BitsetHash> result;
+
+    result[std::bitset<8>("11110000")] = "lock";
+    result[std::bitset<8>("11110010")] = "repne";
+    result[std::bitset<8>("11110011")] = "rep";
+    result[std::bitset<8>("00100110")] = "es";
+    result[std::bitset<8>("00101110")] = "cs";
+    result[std::bitset<8>("00110110")] = "ss";
+    result[std::bitset<8>("00111110")] = "ds";
+
     return result;
 }
\ No newline at end of file
@@ -24,5 +24,11 @@ std::unordered_map<std::bitset<3>, std::string, BitsetHash> getHashValuesRegiste
 std::unordered_map<std::bitset<3>, std::string, BitsetHash> getHashEffAddCalculationFieldEncoding(OperationMod operationMod, const std::string &bitDisplacement);
 std::unordered_map<std::bitset<8>, std::string, BitsetHash> getHashJumpEncoding();
 std::unordered_map<std::bitset<3>, std::string, BitsetHash> getHashAddSubCmpTypeEncoding();
+std::unordered_map<std::bitset<3>, std::string, BitsetHash> getHashShiftRotateEncoding();
+std::unordered_map<std::bitset<3>, std::string, BitsetHash> getHashGroup3Encoding();
+std::unordered_map<std::bitset<3>, std::string, BitsetHash> getHashGroup45Encoding();
+std::unordered_map<std::bitset<2>, std::string, BitsetHash> getHashSegmentRegisterEncoding();
+std::unordered_map<std::bitset<8>, std::string, BitsetHash> getHashSingleByteEncoding();
+std::unordered_map<std::bitset<8>, std::string, BitsetHash> getHashPrefixEncoding();
 
 #endif //HW1_DECODINGHASHMAPS_H
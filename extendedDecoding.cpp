@@ -0,0 +1,375 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include "extendedDecoding.h"
+#include "decodingHashMaps.h"
+#include "byteReader.h"
+
+int getOpcode(const TwoBytes &sixteenBits) {
+    return static_cast<int>(sixteenBits.firstByte.to_ulong());
+}
+
+std::bitset<3> getRegField(const TwoBytes &sixteenBits) {
+    return std::bitset<3>((sixteenBits.secondByte.to_ulong() >> 3) & 0b111);
+}
+
+const std::string &getRegisterName(int wBit, const std::bitset<3> &field) {
+    static const auto byteRegisters = getHashValuesRegisterFieldEncoding(0);
+    static const auto wordRegisters = getHashValuesRegisterFieldEncoding(1);
+
+    return wBit == 1 ? wordRegisters.at(field) : byteRegisters.at(field);
+}
+
+const std::string &getSegmentRegisterName(int field) {
+    static const auto segmentRegisters = getHashSegmentRegisterEncoding();
+    return segmentRegisters.at(std::bitset<2>(field));
+}
+
+// Low byte from the two bytes already read, high byte from the file
+int readWordAfterSecondByte(const TwoBytes &sixteenBits, std::istream &inputFile) {
+    return convertOneByteBase2ToBase10(sixteenBits.secondByte) | (convertOneByteBase2ToBase10(readExtraByte(inputFile)) << 8);
+}
+
+// Text of the r/m operand, a register or a memory operand. Reads the displacement and fills the effective address.
+std::string decodeRmOperand(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
+                            ProgramOutput &programOutput) {
+    int additionalBytesNb = getModAndDecodeExtraBytes(sixteenBits, instruction);
+    std::bitset<3> rmField(sixteenBits.secondByte.to_ulong() & 0b111);
+    if (instruction.operationMod == RegisterMode)
+        return getRegisterName(instruction.wBit, rmField);
+
+    bool directAddress = instruction.operationMod == MemoryModeNoDisplacement && rmField == std::bitset<3>("110");
+    if (directAddress)
+        additionalBytesNb = 2;
+
+    std::string byteDisplacement = readExtraBytes(inputFile, additionalBytesNb);
+    decodeEffectiveAddress(instruction, rmField, byteDisplacement);
+    instruction.effectiveAddress = computeEffectiveAddress(instruction, programOutput.registerValueMap);
+    instruction.operationSize = instruction.wBit == 1 ? "word" : "byte";
+
+    if (directAddress)
+        return "[" + byteDisplacement + "]";
+    return getHashEffAddCalculationFieldEncoding(instruction.operationMod, byteDisplacement)[rmField];
+}
+
+// Consumes the prefixes in front of the instruction, sixteenBits then holds its first two bytes
+int decodePrefixes(TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, std::string &segmentOverride) {
+    static const auto prefixEncoding = getHashPrefixEncoding();
+    int prefixLength = 0;
+
+    while (getOperation(sixteenBits) == InstructionPrefix) {
+        const std::string &prefix = prefixEncoding.at(sixteenBits.firstByte);
+        if (prefix.size() == 2)
+            segmentOverride = prefix + ":";
+        else
+            instruction.prefix += prefix + " ";
+
+        sixteenBits.firstByte = sixteenBits.secondByte;
+        sixteenBits.secondByte = readExtraByte(inputFile);
+        prefixLength++;
+    }
+
+    return prefixLength;
+}
+
+// es: [bx] -> es:[bx], on whichever operand is in memory
+void applySegmentOverride(X8086Instruction &instruction, const std::string &segmentOverride) {
+    for (std::string *operand : {&instruction.destReg, &instruction.sourceReg}) {
+        size_t position = operand->find('[');
+        if (position != std::string::npos)
+            operand->insert(position, segmentOverride);
+    }
+}
+
+// or, adc, sbb, and, xor (00 to 3F), test and xchg (84 to 87)
+void decodeArithmeticRegMemoryAndReg(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
+                                     ProgramOutput &programOutput) {
+    static const auto arithmeticEncoding = getHashAddSubCmpTypeEncoding();
+    int opcode = getOpcode(sixteenBits);
+
+    instruction.wBit = sixteenBits.firstByte[0];
+    if (opcode < 0x40) {
+        instruction.mnemonic = arithmeticEncoding.at(std::bitset<3>(opcode >> 3));
+        instruction.dBit = sixteenBits.firstByte[1];
+    } else {
+        instruction.mnemonic = opcode < 0x86 ? "test" : "xchg";
+        instruction.dBit = 0; // no d bit, both write their first operand
+    }
+
+    std::string rmOperand = decodeRmOperand(sixteenBits, inputFile, instruction, programOutput);
+    const std::string &regOperand = getRegisterName(instruction.wBit, getRegField(sixteenBits));
+    instruction.operationSize.clear(); // given by the register
+    if (instruction.dBit == 1) {
+        instruction.destReg = regOperand;
+        instruction.sourceReg = rmOperand;
+    } else {
+        instruction.destReg = rmOperand;
+        instruction.sourceReg = regOperand;
+    }
+}
+
+// or, adc, sbb, and, xor al/ax, immediate and test al/ax, immediate (A8, A9)
+void decodeArithmeticImmediateToAcc(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction) {
+    static const auto arithmeticEncoding = getHashAddSubCmpTypeEncoding();
+    int opcode = getOpcode(sixteenBits);
+
+    instruction.mnemonic = opcode < 0x40 ? arithmeticEncoding.at(std::bitset<3>(opcode >> 3)) : "test";
+    instruction.wBit = sixteenBits.firstByte[0];
+    instruction.destReg = instruction.wBit == 1 ? "ax" : "al";
+    if (instruction.wBit == 1)
+        instruction.sourceReg = std::to_string(readWordAfterSecondByte(sixteenBits, inputFile));
+    else
+        instruction.sourceReg = std::to_string(convertOneByteBase2ToBase10(sixteenBits.secondByte));
+}
+
+void decodePushPop(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
+                   ProgramOutput &programOutput) {
+    int opcode = getOpcode(sixteenBits);
+    instruction.wBit = 1;
+
+    if (opcode == 0x8F) { // pop r/m
+        instruction.mnemonic = "pop";
+        instruction.destReg = decodeRmOperand(sixteenBits, inputFile, instruction, programOutput);
+        return;
+    }
+
+    ungetSecondByte(inputFile);
+    if (opcode >= 0x50) { // 01010reg push, 01011reg pop
+        instruction.mnemonic = opcode < 0x58 ? "push" : "pop";
+        std::string registerName = getRegisterName(1, std::bitset<3>(opcode & 0b111));
+        if (opcode < 0x58)
+            instruction.sourceReg = registerName;
+        else
+            instruction.destReg = registerName;
+    } else { // 000sr110 push, 000sr111 pop
+        instruction.mnemonic = (opcode & 1) == 0 ? "push" : "pop";
+        std::string registerName = getSegmentRegisterName((opcode >> 3) & 0b11);
+        if ((opcode & 1) == 0)
+            instruction.sourceReg = registerName;
+        else
+            instruction.destReg = registerName;
+    }
+}
+
+void decodeIncDecRegister(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction) {
+    int opcode = getOpcode(sixteenBits);
+    ungetSecondByte(inputFile);
+
+    instruction.wBit = 1;
+    instruction.mnemonic = opcode < 0x48 ? "inc" : "dec";
+    instruction.destReg = getRegisterName(1, std::bitset<3>(opcode & 0b111));
+}
+
+void decodeXchgWithAccumulator(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction) {
+    int opcode = getOpcode(sixteenBits);
+    ungetSecondByte(inputFile);
+
+    instruction.wBit = 1;
+    if (opcode == 0x90) { // xchg ax, ax
+        instruction.mnemonic = "nop";
+        return;
+    }
+    instruction.mnemonic = "xchg";
+    instruction.destReg = "ax";
+    instruction.sourceReg = getRegisterName(1, std::bitset<3>(opcode & 0b111));
+}
+
+// D0 to D3: shift or rotate r/m by 1 (v = 0) or by cl (v = 1)
+void decodeShiftRotate(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
+                       ProgramOutput &programOutput) {
+    static const auto shiftRotateEncoding = getHashShiftRotateEncoding();
+
+    instruction.wBit = sixteenBits.firstByte[0];
+    instruction.mnemonic = shiftRotateEncoding.at(getRegField(sixteenBits));
+    instruction.destReg = decodeRmOperand(sixteenBits, inputFile, instruction, programOutput);
+    instruction.sourceReg = sixteenBits.firstByte[1] ? "cl" : "1";
+}
+
+void decodeGroup3(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
+                  ProgramOutput &programOutput) {
+    static const auto group3Encoding = getHashGroup3Encoding();
+
+    instruction.wBit = sixteenBits.firstByte[0];
+    instruction.mnemonic = group3Encoding.at(getRegField(sixteenBits));
+    std::string rmOperand = decodeRmOperand(sixteenBits, inputFile, instruction, programOutput);
+
+    if (instruction.mnemonic == "test") {
+        instruction.destReg = rmOperand;
+        instruction.sourceReg = readExtraBytes(inputFile, instruction.wBit == 1 ? 2 : 1);
+    } else if (instruction.mnemonic == "not" || instruction.mnemonic == "neg") {
+        instruction.destReg = rmOperand;
+    } else { // mul, imul, div, idiv: ax (and dx) are implied
+        instruction.dBit = 1;
+        instruction.sourceReg = rmOperand;
+    }
+}
+
+// FE only has inc and dec (/0, /1), FF has everything but /7
+bool isDefinedGroup45(const TwoBytes &sixteenBits) {
+    int regField = static_cast<int>(getRegField(sixteenBits).to_ulong());
+    return getOpcode(sixteenBits) == 0xFE ? regField <= 1 : regField != 7;
+}
+
+void decodeGroup45(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
+                   ProgramOutput &programOutput) {
+    static const auto group45Encoding = getHashGroup45Encoding();
+    std::bitset<3> regField = getRegField(sixteenBits);
+
+    instruction.wBit = sixteenBits.firstByte[0];
+    instruction.mnemonic = group45Encoding.at(regField);
+    std::string rmOperand = decodeRmOperand(sixteenBits, inputFile, instruction, programOutput);
+
+    if (instruction.mnemonic == "inc" || instruction.mnemonic == "dec") {
+        instruction.destReg = rmOperand;
+    } else {
+        instruction.dBit = 1;
+        instruction.sourceReg = rmOperand;
+        if (regField == std::bitset<3>("011") || regField == std::bitset<3>("101"))
+            instruction.operationSize = "far";
+        else if (instruction.mnemonic != "push")
+            instruction.operationSize.clear(); // near call/jmp [bx]
+    }
+}
+
+void decodeCallJumpReturn(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction) {
+    static const auto singleByteEncoding = getHashSingleByteEncoding();
+    int opcode = getOpcode(sixteenBits);
+
+    switch (opcode) {
+        case 0xE8: // call near, 16-bit displacement
+        case 0xE9: { // jmp near
+            instruction.mnemonic = opcode == 0xE8 ? "call" : "jmp";
+            int displacement = readWordAfterSecondByte(sixteenBits, inputFile);
+            instruction.sourceReg = std::to_string(displacement);
+            instruction.jumpDisplacement = static_cast<int16_t>(displacement);
+            break;
+        }
+        case 0xEB: // jmp short
+            instruction.mnemonic = "jmp";
+            instruction.sourceReg = std::to_string(convertOneByteBase2ToBase10(sixteenBits.secondByte));
+            instruction.jumpDisplacement = convertOneByteBase2ToSignedBase10(sixteenBits.secondByte);
+            break;
+        case 0x9A: // call far, offset then segment
+        case 0xEA: { // jmp far
+            instruction.mnemonic = opcode == 0x9A ? "call" : "jmp";
+            int offset = readWordAfterSecondByte(sixteenBits, inputFile);
+            int segment = std::stoi(readExtraBytes(inputFile, 2));
+            instruction.sourceReg = std::to_string(segment) + ":" + std::to_string(offset);
+            break;
+        }
+        case 0xC2: // ret imm16
+        case 0xCA: // retf imm16
+            instruction.mnemonic = opcode == 0xC2 ? "ret" : "retf";
+            instruction.sourceReg = std::to_string(readWordAfterSecondByte(sixteenBits, inputFile));
+            break;
+        case 0xCD: // int imm8
+            instruction.mnemonic = "int";
+            instruction.sourceReg = std::to_string(convertOneByteBase2ToBase10(sixteenBits.secondByte));
+            break;
+        default: // ret, retf, int3, into, iret
+            ungetSecondByte(inputFile);
+            instruction.mnemonic = singleByteEncoding.at(sixteenBits.firstByte);
+            break;
+    }
+}
+
+// 8C: mov r/m16, sreg. 8E: mov sreg, r/m16
+void decodeSegmentRegisterMove(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
+                               ProgramOutput &programOutput) {
+    instruction.mnemonic = "mov";
+    instruction.wBit = 1;
+    instruction.dBit = sixteenBits.firstByte[1];
+
+    std::string rmOperand = decodeRmOperand(sixteenBits, inputFile, instruction, programOutput);
+    std::string segmentRegister = getSegmentRegisterName(static_cast<int>(getRegField(sixteenBits).to_ulong() & 0b11));
+    instruction.operationSize.clear();
+    if (instruction.dBit == 1) {
+        instruction.destReg = segmentRegister;
+        instruction.sourceReg = rmOperand;
+    } else {
+        instruction.destReg = rmOperand;
+        instruction.sourceReg = segmentRegister;
+    }
+}
+
+// lea (8D), les (C4), lds (C5): reg16, memory
+void decodeLoadAddress(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
+                       ProgramOutput &programOutput) {
+    int opcode = getOpcode(sixteenBits);
+    instruction.mnemonic = opcode == 0x8D ? "lea" : (opcode == 0xC4 ? "les" : "lds");
+    instruction.wBit = 1;
+    instruction.dBit = 1;
+
+    instruction.sourceReg = decodeRmOperand(sixteenBits, inputFile, instruction, programOutput);
+    instruction.destReg = getRegisterName(1, getRegField(sixteenBits));
+    instruction.operationSize.clear();
+    if (opcode == 0x8D)
+        instruction.effectiveAddressForm = -1; // only the address is computed, memory isn't accessed
+}
+
+// A0, A1: mov al/ax, [address]. A2, A3: mov [address], al/ax
+void decodeMovAccumulatorMemory(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction) {
+    instruction.mnemonic = "mov";
+    instruction.wBit = sixteenBits.firstByte[0];
+    instruction.dBit = sixteenBits.firstByte[1] ? 0 : 1;
+
+    int address = readWordAfterSecondByte(sixteenBits, inputFile);
+    instruction.effectiveAddressForm = 8;
+    instruction.displacement = address;
+    instruction.effectiveAddress = address;
+
+    std::string accumulator = instruction.wBit == 1 ? "ax" : "al";
+    std::string memoryOperand = "[" + std::to_string(address) + "]";
+    instruction.destReg = instruction.dBit == 1 ? accumulator : memoryOperand;
+    instruction.sourceReg = instruction.dBit == 1 ? memoryOperand : accumulator;
+}
+
+// C6, C7: mov r/m, immediate
+void decodeMovImmediateToMemory(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
+                                ProgramOutput &programOutput) {
+    instruction.mnemonic = "mov";
+    instruction.wBit = sixteenBits.firstByte[0];
+
+    instruction.destReg = decodeRmOperand(sixteenBits, inputFile, instruction, programOutput);
+    instruction.sourceReg = readExtraBytes(inputFile, instruction.wBit == 1 ? 2 : 1);
+}
+
+// E4 to E7: fixed port. EC to EF: port in dx
+void decodeInputOutput(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction) {
+    int opcode = getOpcode(sixteenBits);
+    instruction.wBit = sixteenBits.firstByte[0];
+    instruction.mnemonic = sixteenBits.firstByte[1] ? "out" : "in";
+
+    std::string port = "dx";
+    if (opcode < 0xE8)
+        port = std::to_string(convertOneByteBase2ToBase10(sixteenBits.secondByte));
+    else
+        ungetSecondByte(inputFile);
+
+    std::string accumulator = instruction.wBit == 1 ? "ax" : "al";
+    instruction.destReg = instruction.mnemonic == "in" ? accumulator : port;
+    instruction.sourceReg = instruction.mnemonic == "in" ? port : accumulator;
+}
+
+void decodeNoOperandInstruction(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction) {
+    static const auto singleByteEncoding = getHashSingleByteEncoding();
+    int opcode = getOpcode(sixteenBits);
+
+    instruction.mnemonic = singleByteEncoding.at(sixteenBits.firstByte);
+    if (opcode != 0xD4 && opcode != 0xD5) // aam and aad have a second byte (0A)
+        ungetSecondByte(inputFile);
+}
+
+// D8 to DF: coprocessor instruction, the 8086 only computes the address
+void decodeEscape(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
+                  ProgramOutput &programOutput) {
+    instruction.mnemonic = "esc";
+    instruction.wBit = 1;
+    instruction.dBit = 1;
+
+    int escapeCode = ((getOpcode(sixteenBits) & 0b111) << 3) | static_cast<int>(getRegField(sixteenBits).to_ulong());
+    instruction.sourceReg = decodeRmOperand(sixteenBits, inputFile, instruction, programOutput);
+    instruction.destReg = std::to_string(escapeCode);
+    instruction.operationSize.clear();
+}
@@ -0,0 +1,37 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_EXTENDEDDECODING_H
+#define HW1_EXTENDEDDECODING_H
+
+#include <iostream>
+
+#include "instructionDecoding.h"
+
+/*
+ * Rest of the 8086 opcode map. These handlers only decode: the disassembly is complete and the IP stays in sync,
+ * but registers, flags and memory are not modified.
+ * dBit is set to 1 when the memory operand is only read, so the store hooks ignore it.
+ */
+int decodePrefixes(TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, std::string &segmentOverride);
+void applySegmentOverride(X8086Instruction &instruction, const std::string &segmentOverride);
+void decodeArithmeticRegMemoryAndReg(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, ProgramOutput &programOutput);
+void decodeArithmeticImmediateToAcc(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction);
+void decodePushPop(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, ProgramOutput &programOutput);
+void decodeIncDecRegister(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction);
+void decodeXchgWithAccumulator(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction);
+void decodeShiftRotate(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, ProgramOutput &programOutput);
+void decodeGroup3(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, ProgramOutput &programOutput);
+bool isDefinedGroup45(const TwoBytes &sixteenBits);
+void decodeGroup45(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, ProgramOutput &programOutput);
+void decodeCallJumpReturn(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction);
+void decodeSegmentRegisterMove(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, ProgramOutput &programOutput);
+void decodeLoadAddress(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, ProgramOutput &programOutput);
+void decodeMovAccumulatorMemory(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction);
+void decodeMovImmediateToMemory(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, ProgramOutput &programOutput);
+void decodeInputOutput(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction);
+void decodeNoOperandInstruction(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction);
+void decodeEscape(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, ProgramOutput &programOutput);
+
+#endif //HW1_EXTENDEDDECODING_H
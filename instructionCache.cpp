@@ -0,0 +1,95 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include <algorithm>
+
+#include "instructionCache.h"
+#include "registerState.h"
+
+const CachedInstruction *findCachedInstruction(const InstructionCache &cache, int address) {
+    if (cache.entries.empty())
+        return nullptr;
+
+    auto iterator = cache.entries.find(address);
+    if (iterator == cache.entries.end())
+        return nullptr;
+
+    return &iterator->second;
+}
+
+void recordInterpretedInstruction(InstructionCache &cache, int address, int size, const X8086Instruction &instruction) {
+    cache.stats.interpreted++;
+    if (cache.hotThreshold == 0 || instruction.operation == NotFound)
+        return;
+
+    int &count = cache.executionCounts[address];
+    if (++count < cache.hotThreshold)
+        return;
+
+    CachedInstruction cached;
+    cached.instruction = instruction;
+    cached.size = size;
+    if (instruction.operation == MovImmediateToRegister)
+        cached.immediate = std::stoi(instruction.sourceReg);
+
+    cache.entries[address] = cached;
+    cache.executionCounts.erase(address);
+    cache.longestCachedInstruction = std::max(cache.longestCachedInstruction, size);
+    for (int page = address >> codePageShift; page <= ((address + size - 1) & 0xffff) >> codePageShift; ++page)
+        cache.codePages.set(page);
+}
+
+// Drops every cached instruction with at least one byte in [address, address + width)
+void invalidateCachedCode(InstructionCache &cache, int address, int width) {
+    for (int start = address - cache.longestCachedInstruction + 1; start < address + width; ++start) {
+        auto iterator = cache.entries.find(start);
+        if (iterator == cache.entries.end() || start + iterator->second.size <= address)
+            continue;
+
+        cache.entries.erase(iterator);
+        cache.executionCounts.erase(start); // has to get hot again with its new bytes
+        cache.stats.invalidations++;
+    }
+}
+
+// Same register/flag updates as the interpreter handlers, without any decoding. Returns the next IP.
+int executeCachedInstruction(const CachedInstruction &cached, int address, ProgramOutput &programOutput) {
+    const X8086Instruction &instruction = cached.instruction;
+    int nextAddress = address + cached.size;
+
+    switch (instruction.operation) {
+        case MovRegisterToRegister:
+        case AddRegisterToRegister:
+        case SubRegMemoryAndRegToEither:
+        case CmpRegisterMemoryAndRegister:
+        case AddImmediateToAccumulator:
+        case SubImmediateFromAccumulator:
+        case CmpImmediateWithAccumulator:
+            computeAddSubCmpAndSetZeroFlag(instruction, instruction.mnemonic, programOutput);
+            break;
+        case MovImmediateToRegister:
+            updateRegisterValueMap(programOutput.registerValueMap, instruction.destReg, cached.immediate);
+            break;
+        case XImmediateToRegisterOrMemory:
+            computeDirectAddSubCmpAndSetZeroFlag(instruction, instruction.mnemonic, programOutput);
+            break;
+        case JumpInstruction:
+            if (checkJumpCondition(instruction.mnemonic, programOutput))
+                nextAddress += instruction.jumpDisplacement;
+            break;
+        default:
+            break;
+    }
+
+    return nextAddress;
+}
+
+void printInstructionCacheStats(const InstructionCache &cache) {
+    std::cout << "Interpreted : " << cache.stats.interpreted << std::endl
+              << "Cache hits  : " << cache.stats.cacheHits << std::endl
+              << "Cached      : " << cache.entries.size() << std::endl
+              << "Invalidated : " << cache.stats.invalidations << std::endl;
+    if (cache.differential)
+        std::cout << "Mismatches  : " << cache.stats.differentialMismatches << std::endl;
+}
@@ -0,0 +1,69 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_INSTRUCTIONCACHE_H
+#define HW1_INSTRUCTIONCACHE_H
+
+#include <bitset>
+#include <string>
+#include <unordered_map>
+
+#include "instructionDecoding.h"
+
+/*
+ * Pre-decoded form of an instruction that was executed often enough to be "hot".
+ * Replaying it skips the file read and the whole bit-level decoding.
+ */
+struct CachedInstruction {
+    X8086Instruction instruction;
+    int size = 0; // in bytes
+    int immediate = 0; // parsed source value for mov immediate
+};
+
+struct InstructionCacheStats {
+    long long interpreted = 0;
+    long long cacheHits = 0;
+    long long differentialMismatches = 0;
+    long long invalidations = 0; // cached instructions dropped because a store hit their bytes
+};
+
+// Self-modifying code : pages of 256 bytes that hold at least one cached instruction
+const int codePageShift = 8;
+const int codePageCount = 0x10000 >> codePageShift;
+
+struct InstructionCache {
+    /*
+     * Number of executions after which an instruction gets cached
+     * 0 -> cache disabled, only the interpreter runs
+     */
+    int hotThreshold = 2;
+    /*
+     * Differential mode: every cached execution is also replayed by the interpreter,
+     * and the resulting states are compared
+     */
+    bool differential = false;
+    std::unordered_map<int, int> executionCounts;
+    std::unordered_map<int, CachedInstruction> entries;
+    std::bitset<codePageCount> codePages;
+    int longestCachedInstruction = 0; // in bytes, prefixes included: how far back a store can hit a cached instruction
+    InstructionCacheStats stats;
+};
+
+const CachedInstruction *findCachedInstruction(const InstructionCache &cache, int address);
+void recordInterpretedInstruction(InstructionCache &cache, int address, int size, const X8086Instruction &instruction);
+void invalidateCachedCode(InstructionCache &cache, int address, int width);
+
+// Called for every guest store: stores to data pages only cost the bitmap test
+inline void notifyGuestStore(InstructionCache &cache, int address, int width) {
+    int lastAddress = (address + width - 1) & 0xffff;
+    if (!cache.codePages.test(address >> codePageShift) && !cache.codePages.test(lastAddress >> codePageShift)) [[likely]]
+        return;
+
+    invalidateCachedCode(cache, address, width);
+}
+
+int executeCachedInstruction(const CachedInstruction &cached, int address, ProgramOutput &programOutput);
+void printInstructionCacheStats(const InstructionCache &cache);
+
+#endif //HW1_INSTRUCTIONCACHE_H
@@ -2,13 +2,241 @@
 // Created by rob on 18/03/24.
 //
 
+#include <array>
 #include <vector>
 #include <iomanip>
 #include "instructionDecoding.h"
+#include "extendedDecoding.h"
 #include "decodingHashMaps.h"
 #include "byteReader.h"
 #include "registerState.h"
 
+// One entry per first byte of the 8086 opcode map
+std::array<OperationName, 256> buildOperationTable() {
+    std::array<OperationName, 256> table{};
+    table.fill(NotFound);
+    auto setRange = [&table](int firstOpcode, int lastOpcode, OperationName operation) {
+        for (int opcode = firstOpcode; opcode <= lastOpcode; ++opcode)
+            table[opcode] = operation;
+    };
+
+    // 00 to 3F: eight arithmetic operations, each with 4 r/m forms and 2 accumulator forms
+    for (int operationBase = 0x00; operationBase < 0x40; operationBase += 8) {
+        setRange(operationBase, operationBase + 3, ArithmeticRegMemoryAndReg);
+        setRange(operationBase + 4, operationBase + 5, ArithmeticImmediateToAccumulator);
+    }
+    setRange(0x00, 0x03, AddRegisterToRegister);
+    setRange(0x04, 0x05, AddImmediateToAccumulator);
+    setRange(0x28, 0x2B, SubRegMemoryAndRegToEither);
+    setRange(0x2C, 0x2D, SubImmediateFromAccumulator);
+    setRange(0x38, 0x3B, CmpRegisterMemoryAndRegister);
+    setRange(0x3C, 0x3D, CmpImmediateWithAccumulator);
+    for (int opcode : {0x06, 0x07, 0x0E, 0x16, 0x17, 0x1E, 0x1F, 0x8F})
+        table[opcode] = PushPopInstruction;
+    for (int opcode : {0x26, 0x2E, 0x36, 0x3E, 0xF0, 0xF2, 0xF3})
+        table[opcode] = InstructionPrefix;
+    for (int opcode : {0x27, 0x2F, 0x37, 0x3F, 0x98, 0x99, 0x9B, 0x9C, 0x9D, 0x9E, 0x9F, 0xD4, 0xD5, 0xD7,
+                       0xF4, 0xF5, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD})
+        table[opcode] = NoOperandInstruction;
+
+    setRange(0x40, 0x4F, IncDecRegister);
+    setRange(0x50, 0x5F, PushPopInstruction);
+    setRange(0x70, 0x7F, JumpInstruction);
+    setRange(0x80, 0x83, XImmediateToRegisterOrMemory);
+    setRange(0x84, 0x87, ArithmeticRegMemoryAndReg); // test, xchg
+    setRange(0x88, 0x8B, MovRegisterToRegister);
+    table[0x8C] = SegmentRegisterMove;
+    table[0x8D] = LoadAddress;
+    table[0x8E] = SegmentRegisterMove;
+    setRange(0x90, 0x97, XchgWithAccumulator);
+    table[0x9A] = CallJumpReturn;
+    setRange(0xA0, 0xA3, MovAccumulatorMemory);
+    setRange(0xA4, 0xA7, StringInstruction);
+    setRange(0xA8, 0xA9, ArithmeticImmediateToAccumulator); // test
+    setRange(0xAA, 0xAF, StringInstruction);
+    setRange(0xB0, 0xBF, MovImmediateToRegister);
+    for (int opcode : {0xC2, 0xC3, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF, 0xE8, 0xE9, 0xEA, 0xEB})
+        table[opcode] = CallJumpReturn;
+    setRange(0xC4, 0xC5, LoadAddress);
+    setRange(0xC6, 0xC7, MovImmediateToMemory);
+    setRange(0xD0, 0xD3, ShiftRotateInstruction);
+    setRange(0xD8, 0xDF, EscapeInstruction);
+    setRange(0xE0, 0xE3, JumpInstruction); // loop family, jcxz
+    setRange(0xE4, 0xE7, InputOutput);
+    setRange(0xEC, 0xEF, InputOutput);
+    setRange(0xF6, 0xF7, Group3Instruction);
+    setRange(0xFE, 0xFF, Group45Instruction);
+
+    return table;
+}
+
+OperationName getOperation(const TwoBytes &inputBits) {
+    static const std::array<OperationName, 256> operationTable = buildOperationTable();
+    return operationTable[inputBits.firstByte.to_ulong()];
+}
+
+void executeOperation(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
+                      ProgramOutput &programOutput, InstructionPointer &ip) {
+    TwoBytes opcodeBytes = sixteenBits;
+    std::string segmentOverride;
+    ip.ip += decodePrefixes(opcodeBytes, inputFile, instruction, segmentOverride);
+
+    instruction.operation = getOperation(opcodeBytes);
+    if (instruction.operation == Group45Instruction && !isDefinedGroup45(opcodeBytes))
+        instruction.operation = NotFound; // undefined reg field, skipped like an unknown opcode
+    //addBinaryToStringVector(programOutput.instructionPrinter, opcodeBytes); // debugging
+    //std::cout << opcodeBytes.firstByte << " " << opcodeBytes.secondByte << std::endl;
+
+    switch (instruction.operation) {
+        case MovRegisterToRegister:
+            outputRegToReg(opcodeBytes, inputFile, instruction, "mov", programOutput, ip);
+            break;
+        case AddRegisterToRegister:
+            outputRegToReg(opcodeBytes, inputFile, instruction, "add", programOutput, ip);
+            break;
+        case SubRegMemoryAndRegToEither:
+            outputRegToReg(opcodeBytes, inputFile, instruction, "sub", programOutput, ip);
+            break;
+        case CmpRegisterMemoryAndRegister:
+            outputRegToReg(opcodeBytes, inputFile, instruction, "cmp", programOutput, ip);
+            break;
+        case MovImmediateToRegister:
+            outputImmediateToReg(opcodeBytes, inputFile, instruction, "mov", programOutput, ip);
+            break;
+        case AddImmediateToAccumulator:
+            decodeImmediateToAcc(opcodeBytes, inputFile, instruction, "add", programOutput, ip);
+            break;
+        case SubImmediateFromAccumulator:
+            decodeImmediateToAcc(opcodeBytes, inputFile, instruction, "sub", programOutput, ip);
+            break;
+        case CmpImmediateWithAccumulator:
+            decodeImmediateToAcc(opcodeBytes, inputFile, instruction, "cmp", programOutput, ip);
+            break;
+        case JumpInstruction:
+            decodeJumpInstruction(instruction, opcodeBytes, programOutput, ip);
+            break;
+        case XImmediateToRegisterOrMemory:
+            decodeImmediateInstruction(opcodeBytes, inputFile, instruction, programOutput, ip);
+            break;
+        case ArithmeticRegMemoryAndReg:
+            decodeArithmeticRegMemoryAndReg(opcodeBytes, inputFile, instruction, programOutput);
+            break;
+        case ArithmeticImmediateToAccumulator:
+            decodeArithmeticImmediateToAcc(opcodeBytes, inputFile, instruction);
+            break;
+        case PushPopInstruction:
+            decodePushPop(opcodeBytes, inputFile, instruction, programOutput);
+            break;
+        case IncDecRegister:
+            decodeIncDecRegister(opcodeBytes, inputFile, instruction);
+            break;
+        case XchgWithAccumulator:
+            decodeXchgWithAccumulator(opcodeBytes, inputFile, instruction);
+            break;
+        case ShiftRotateInstruction:
+            decodeShiftRotate(opcodeBytes, inputFile, instruction, programOutput);
+            break;
+        case Group3Instruction:
+            decodeGroup3(opcodeBytes, inputFile, instruction, programOutput);
+            break;
+        case Group45Instruction:
+            decodeGroup45(opcodeBytes, inputFile, instruction, programOutput);
+            break;
+        case StringInstruction:
+        case NoOperandInstruction:
+            decodeNoOperandInstruction(opcodeBytes, inputFile, instruction);
+            break;
+        case CallJumpReturn:
+            decodeCallJumpReturn(opcodeBytes, inputFile, instruction);
+            break;
+        case SegmentRegisterMove:
+            decodeSegmentRegisterMove(opcodeBytes, inputFile, instruction, programOutput);
+            break;
+        case LoadAddress:
+            decodeLoadAddress(opcodeBytes, inputFile, instruction, programOutput);
+            break;
+        case MovAccumulatorMemory:
+            decodeMovAccumulatorMemory(opcodeBytes, inputFile, instruction);
+            break;
+        case MovImmediateToMemory:
+            decodeMovImmediateToMemory(opcodeBytes, inputFile, instruction, programOutput);
+            break;
+        case InputOutput:
+            decodeInputOutput(opcodeBytes, inputFile, instruction);
+            break;
+        case EscapeInstruction:
+            decodeEscape(opcodeBytes, inputFile, instruction, programOutput);
+            break;
+        default:
+            // Skip a single byte, the next one may start a valid instruction
+            std::cerr << "Operation was not found : " << opcodeBytes.firstByte << " " << opcodeBytes.secondByte << std::endl;
+            ungetSecondByte(inputFile);
+            break;
+    }
+
+    if (!segmentOverride.empty())
+        applySegmentOverride(instruction, segmentOverride);
+
+    // Jumps set the IP themselves. Everything else continues right after the bytes that were consumed.
+    if (instruction.operation != JumpInstruction)
+        ip.ip = static_cast<int>(inputFile.tellg());
+}
+
+// Disassembly text, as printed in the '=== Instructions ==' section
+int getInstructionTextPieces(const X8086Instruction &instruction, std::array<std::string_view, 8> &pieces) {
+    int count = 0;
+    pieces[count++] = instruction.prefix;
+    pieces[count++] = instruction.mnemonic;
+    if (instruction.destReg.empty() && instruction.sourceReg.empty()) // ret, movsb...
+        return count;
+
+    pieces[count++] = " ";
+    if (!instruction.operationSize.empty()) {
+        pieces[count++] = instruction.operationSize;
+        pieces[count++] = " ";
+    }
+
+    if (instruction.destReg.empty()) { // jumps, push, call...
+        pieces[count++] = instruction.sourceReg;
+    } else if (instruction.sourceReg.empty()) { // inc, pop, not...
+        pieces[count++] = instruction.destReg;
+    } else {
+        pieces[count++] = instruction.destReg;
+        pieces[count++] = ", ";
+        pieces[count++] = instruction.sourceReg;
+    }
+
+    return count;
+}
+
+std::string formatInstruction(const X8086Instruction &instruction) {
+    std::array<std::string_view, 8> pieces;
+    int count = getInstructionTextPieces(instruction, pieces);
+
+    std::string output;
+    for (int i = 0; i < count; ++i)
+        output += pieces[i];
+
+    return output;
+}
+
+// Same text, written straight into the arena without any temporary string
+std::string_view formatInstruction(const X8086Instruction &instruction, TextArena &arena) {
+    std::array<std::string_view, 8> pieces;
+    int count = getInstructionTextPieces(instruction, pieces);
+
+    size_t length = 0;
+    for (int i = 0; i < count; ++i)
+        length += pieces[i].size();
+
+    char *text = allocateText(arena, length);
+    char *cursor = text;
+    for (int i = 0; i < count; ++i)
+        cursor = std::copy(pieces[i].begin(), pieces[i].end(), cursor);
+
+    return {text, length};
+}
+
 void showAsHexa(int intValue) {
     std::cout << "IP : 0x"
               << std::setfill('0') << std::setw(4)
@@ -18,22 +246,60 @@ void showAsHexa(int intValue) {
               << std::endl;
 }
 
-void decodeJumpInstruction(X8086Instruction &instruction, const TwoBytes &sixteenBits, ProgramOutput &programOutput, InstructionPointer &ip) {
+bool decodeJumpInstruction(X8086Instruction &instruction, const TwoBytes &sixteenBits, ProgramOutput &programOutput, InstructionPointer &ip) {
     auto hashJumpEncoding = getHashJumpEncoding();
-    std::string instrName = hashJumpEncoding[sixteenBits.firstByte];
+    instruction.mnemonic = hashJumpEncoding[sixteenBits.firstByte];
     instruction.sourceReg = std::to_string(convertOneByteBase2ToBase10(sixteenBits.secondByte));
+    instruction.jumpDisplacement = convertOneByteBase2ToSignedBase10(sixteenBits.secondByte);
 
-    std::string output = instrName + " " + instruction.sourceReg;
-    programOutput.instructionPrinter.emplace_back(output);
-    //std::cout << output << std::endl;
+    ip.ip += 2; // opcode + displacement
+    if (checkJumpCondition(instruction.mnemonic, programOutput)) {
+        ip.ip += instruction.jumpDisplacement;
+        return true;
+    }
 
-    if (instrName == "JNZ" && programOutput.flags.zeroFlag == 0) {
-        ip.ip = std::stoi(instruction.sourceReg);
+    return false;
+}
 
+bool checkJumpCondition(const std::string &jumpName, ProgramOutput &programOutput) {
+    const InstructionFlags &flags = programOutput.flags;
+
+    if (jumpName == "jnz")
+        return !flags.zeroFlag;
+    if (jumpName == "je")
+        return flags.zeroFlag;
+    if (jumpName == "js")
+        return flags.signFlag;
+    if (jumpName == "jns")
+        return !flags.signFlag;
+
+    // loop family decrements cx first (without touching the flags)
+    if (jumpName == "loop" || jumpName == "loopz" || jumpName == "loopnz") {
+        int &cx = programOutput.registerValueMap["cx"];
+        cx = (cx - 1) & 0xffff;
+        if (jumpName == "loopz")
+            return cx != 0 && flags.zeroFlag;
+        if (jumpName == "loopnz")
+            return cx != 0 && !flags.zeroFlag;
+        return cx != 0;
     }
+    if (jumpName == "jcxz")
+        return programOutput.registerValueMap["cx"] == 0;
+
+    // Carry, parity and overflow are not simulated yet -> never taken
+    return false;
+}
+
+// 'data' of the immediate group. With s = 1 and w = 1 the single byte is sign-extended to the word.
+std::string readImmediateData(std::istream &inputFile, const X8086Instruction &instruction, int dataByte) {
+    std::string immediate = readExtraBytes(inputFile, dataByte);
+    if (instruction.sBit == 1 && instruction.wBit == 1)
+        immediate = std::to_string(static_cast<int8_t>(std::stoi(immediate)) & 0xffff);
+
+    return immediate;
 }
 
-void decodeImmediateInstruction(const TwoBytes &sixteenBits, std::ifstream &inputFile, X8086Instruction &instruction, ProgramOutput &programOutput, InstructionPointer &ip) {
+void decodeImmediateInstruction(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, ProgramOutput &programOutput, InstructionPointer &ip) {
     instruction.sBit = sixteenBits.firstByte[1];
     // right-most bit
     instruction.wBit = sixteenBits.firstByte[0];
@@ -50,6 +316,7 @@ void decodeImmediateInstruction(const TwoBytes &sixteenBits, std::ifstream &inpu
 
     auto operationTypeHashMap = getHashAddSubCmpTypeEncoding();
     auto operationType = operationTypeHashMap[operationField];
+    instruction.mnemonic = operationType;
 
     // Get value of 'r/m' register
     int additionalBytesNb = getModAndDecodeExtraBytes(sixteenBits, instruction);
@@ -60,65 +327,46 @@ void decodeImmediateInstruction(const TwoBytes &sixteenBits, std::ifstream &inpu
     std::unordered_map<std::bitset<3>, std::string, BitsetHash>
             registerBitsetMap = getHashValuesRegisterFieldEncoding(instruction.wBit);
 
-    std::string operationSize;
-
     int dataByte = 1; // for 'data'
-    if (operationType == "cmp") { // cmp has condition 'data if s: w = 1'
-        //std::cout << "optype 111" << std::endl;
-        if (instruction.sBit == 1 && instruction.wBit == 1)
-            dataByte += 1; // another 'data' byte
-        //std::cout << "dataByte is: " << dataByte << std::endl;
-    } else { // add and sub have condition 'data if s: w = 01'
-        if (instruction.sBit == 0 && instruction.wBit == 1)
-            dataByte += 1; // another 'data' byte
-    }
+    if (instruction.sBit == 0 && instruction.wBit == 1) // 'data if s: w = 01', for all 8 operations
+        dataByte += 1; // another 'data' byte
 
     // Register to register (MOD 11)
     if (instruction.operationMod == RegisterMode) {
         instruction.destReg = registerBitsetMap[rmField];
 
-        //instruction.sourceReg = readExtraBytes(inputFile, dataByte);
-        if (operationType == "cmp")
-            instruction.sourceReg = readTwoBytesAndUseMSB(inputFile, 1);
-        else
-            instruction.sourceReg = readExtraBytes(inputFile, dataByte);
+        instruction.sourceReg = readImmediateData(inputFile, instruction, dataByte);
         ip.ip += 4; // two first bytes, data, data (no disp-lo or disp-high)
     } else { // Mod is 00, 01 or 10
-        if (rmField != std::bitset<3>("110")) {
+        if (instruction.operationMod != MemoryModeNoDisplacement || rmField != std::bitset<3>("110")) {
             std::unordered_map<std::bitset<3>, std::string, BitsetHash>
                     effectiveAddressMap = getHashEffAddCalculationFieldEncoding(instruction.operationMod, byteDisplacement);
             instruction.destReg = effectiveAddressMap[rmField];
+            decodeEffectiveAddress(instruction, rmField, byteDisplacement);
             ip.ip += 1;
         } else { // DIRECT ADDRESS case
             //std::cout << "Special case r/m is 110." << std::endl;
             auto twoBytesDisplacement = readExtraBytes(inputFile, 2);
             ip.ip += 2;
             instruction.destReg = twoBytesDisplacement;
+            decodeEffectiveAddress(instruction, rmField, twoBytesDisplacement);
         }
+        instruction.effectiveAddress = computeEffectiveAddress(instruction, programOutput.registerValueMap);
 
         if (instruction.wBit == 0) {
-            operationSize = "byte";
+            instruction.operationSize = "byte";
         } else {
-            operationSize = "word";
+            instruction.operationSize = "word";
         }
 
-        instruction.sourceReg = readDataBytes(inputFile);
+        instruction.sourceReg = readImmediateData(inputFile, instruction, dataByte);
 
-        ip.ip += 3; // two first bytes, 1 for data
-    }
-
-    std::string output = operationType;
-    if (!operationSize.empty()) {
-        output += " " + operationSize + " " + instruction.destReg + ", " + instruction.sourceReg;
-    } else {
-        output += " " + instruction.destReg + ", " + instruction.sourceReg;
+        ip.ip += 2 + dataByte; // two first bytes, data
     }
 
     // actually do the operation on register
     computeDirectAddSubCmpAndSetZeroFlag(instruction, operationType, programOutput);
-    showAsHexa(ip.ip);
-    programOutput.instructionPrinter.emplace_back(output);
-    //std::cout << output << std::endl;
+    //showAsHexa(ip.ip);
 }
 
 int getModAndDecodeExtraBytes(const TwoBytes &inputBits, X8086Instruction &instruction) {
@@ -143,9 +391,10 @@ int getModAndDecodeExtraBytes(const TwoBytes &inputBits, X8086Instruction &instr
     return -1; // problem
 }
 
-void outputImmediateToReg(const TwoBytes &sixteenBits, std::ifstream &inputFile, X8086Instruction &instruction,
+void outputImmediateToReg(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
                           const std::string &instructionType, ProgramOutput &programOutput, InstructionPointer &ip) {
     //std::cout << "--1011--"<< std::endl;
+    instruction.mnemonic = instructionType;
     bool readAdditionalByte = decodeImmediateToRegInstruction(sixteenBits, instruction);
 
     //std::cout << "additional byte? : " << readAdditionalByte << std::endl;
@@ -182,22 +431,30 @@ void outputImmediateToReg(const TwoBytes &sixteenBits, std::ifstream &inputFile,
     }
 
     ip.ip += 2 + readAdditionalByte ; // first byte + data + data if w = 1
-    showAsHexa(ip.ip);
-    programOutput.instructionPrinter.emplace_back(instructionType + " " + instruction.destReg + ", " + instruction.sourceReg);
+    //showAsHexa(ip.ip);
 }
 
-void outputRegToReg(const TwoBytes &sixteenBits, std::ifstream &inputFile, X8086Instruction &instruction, const std::string& instructionType, ProgramOutput &programOutput, InstructionPointer &ip) {
+void outputRegToReg(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, const std::string& instructionType, ProgramOutput &programOutput, InstructionPointer &ip) {
+    instruction.mnemonic = instructionType;
     int additionalBytesNb = getModAndDecodeExtraBytes(sixteenBits, instruction);
+    std::bitset<3> rmField(sixteenBits.secondByte.to_ulong() & 0b111);
+    if (instruction.operationMod == MemoryModeNoDisplacement && rmField == std::bitset<3>("110"))
+        additionalBytesNb = 2; // DIRECT ADDRESS case
+
     std::string byteDisplacement;
     if (instruction.operationMod == MemoryModeNoDisplacement || instruction.operationMod == MemoryMode16Bit || instruction.operationMod == MemoryMode8Bit)
         byteDisplacement = readExtraBytes(inputFile, additionalBytesNb);
     decodeRegToRegMovInstruction(sixteenBits, instruction, byteDisplacement);
 
+    if (instruction.operationMod != RegisterMode) {
+        decodeEffectiveAddress(instruction, rmField, byteDisplacement);
+        instruction.effectiveAddress = computeEffectiveAddress(instruction, programOutput.registerValueMap);
+    }
+
     // actually do the operation on register
     computeAddSubCmpAndSetZeroFlag(instruction, instructionType, programOutput);
     ip.ip += 2 + additionalBytesNb ; // first + second bytes + 1 (DISP-LO) or 2 (DISP-HI) for the displacements
-    showAsHexa(ip.ip);
-    programOutput.instructionPrinter.emplace_back(instructionType + " " + instruction.destReg + ", " + instruction.sourceReg);
+    //showAsHexa(ip.ip);
 }
 
 void computeAddSubCmpAndSetZeroFlag(const X8086Instruction &instruction, const std::string &instructionType,
@@ -227,17 +484,22 @@ void computeAddSubCmpAndSetZeroFlag(const X8086Instruction &instruction, const s
 void computeDirectAddSubCmpAndSetZeroFlag(const X8086Instruction &instruction, const std::string &instructionType,
                                           ProgramOutput &programOutput) {
     int newValue = 0;
+    int immediate = std::stoi(instruction.sourceReg);
+    if (instruction.sBit == 1 && instruction.wBit == 1) // sign-extended byte: 65535 is -1
+        immediate = static_cast<int16_t>(immediate);
 
     if (instructionType == "cmp") { // no modification on register
-        newValue = programOutput.registerValueMap[instruction.destReg] - programOutput.registerValueMap[instruction.sourceReg];
+        newValue = programOutput.registerValueMap[instruction.destReg] - immediate;
     } else {
         if (instructionType == "mov") {
-            std::cout << "here ; " << instruction.sourceReg;
-            newValue = std::stoi(instruction.sourceReg);
+            //std::cout << "here ; " << instruction.sourceReg;
+            newValue = immediate;
         } else if (instructionType == "add") {
-            newValue = programOutput.registerValueMap[instruction.destReg] + std::stoi(instruction.sourceReg);
-        } else { // sub
-            newValue = programOutput.registerValueMap[instruction.destReg] - std::stoi(instruction.sourceReg);
+            newValue = programOutput.registerValueMap[instruction.destReg] + immediate;
+        } else if (instructionType == "sub") {
+            newValue = programOutput.registerValueMap[instruction.destReg] - immediate;
+        } else {
+            return; // or, adc, sbb, and, xor: decoded only
         }
         // Executed in all cases
         programOutput.flags.signFlag = updateRegisterValueMapAndGetSignFlag(programOutput.registerValueMap,
@@ -247,8 +509,9 @@ void computeDirectAddSubCmpAndSetZeroFlag(const X8086Instruction &instruction, c
     checkZeroFlag(programOutput, newValue); // executed for all instructions
 }
 
+// Registers hold unmasked ints, the flag looks at the 16-bit result (0xffff + 1 -> Z)
 void checkZeroFlag(ProgramOutput &programOutput, int newValue) {
-    if (newValue == 0) {
+    if ((newValue & 0xffff) == 0) {
         programOutput.flags.zeroFlag = true;
         //std::cout << "Z -> 1" << std::endl;
     } else {
@@ -312,18 +575,66 @@ void decodeRegToRegMovInstruction(const TwoBytes &inputBits, X8086Instruction &i
     } else { // Mod is 00, 01 or 10
         std::unordered_map<std::bitset<3>, std::string, BitsetHash>
                 effectiveAddressMap = getHashEffAddCalculationFieldEncoding(instruction.operationMod, byteDisplacement);
+        std::string memoryOperand = effectiveAddressMap[rmField];
+        if (instruction.operationMod == MemoryModeNoDisplacement && rmField == std::bitset<3>("110"))
+            memoryOperand = "[" + byteDisplacement + "]"; // DIRECT ADDRESS case
+
         if (instruction.dBit == 0) {
             instruction.sourceReg = registerBitsetMap[regField];
-            instruction.destReg = effectiveAddressMap[rmField];
+            instruction.destReg = memoryOperand;
         } else {
-            instruction.sourceReg = effectiveAddressMap[rmField];
+            instruction.sourceReg = memoryOperand;
             instruction.destReg = registerBitsetMap[regField];
         }
     }
 }
 
-void decodeImmediateToAcc(const TwoBytes &sixteenBits, std::ifstream &inputFile, X8086Instruction &instruction,
+void decodeEffectiveAddress(X8086Instruction &instruction, const std::bitset<3> &rmField, const std::string &byteDisplacement) {
+    int displacement = byteDisplacement.empty() ? 0 : std::stoi(byteDisplacement);
+
+    if (instruction.operationMod == MemoryModeNoDisplacement && rmField == std::bitset<3>("110")) {
+        instruction.effectiveAddressForm = 8; // direct address
+    } else {
+        instruction.effectiveAddressForm = static_cast<int>(rmField.to_ulong());
+        if (instruction.operationMod == MemoryMode8Bit)
+            displacement = convertOneByteBase2ToSignedBase10(std::bitset<8>(displacement)); // sign-extended
+    }
+
+    instruction.displacement = displacement;
+}
+
+int computeEffectiveAddress(const X8086Instruction &instruction, std::unordered_map<std::string, int> &registerValueMap) {
+    int base = 0;
+
+    switch (instruction.effectiveAddressForm) {
+        case 0: base = registerValueMap["bx"] + registerValueMap["si"]; break;
+        case 1: base = registerValueMap["bx"] + registerValueMap["di"]; break;
+        case 2: base = registerValueMap["bp"] + registerValueMap["si"]; break;
+        case 3: base = registerValueMap["bp"] + registerValueMap["di"]; break;
+        case 4: base = registerValueMap["si"]; break;
+        case 5: base = registerValueMap["di"]; break;
+        case 6: base = registerValueMap["bp"]; break;
+        case 7: base = registerValueMap["bx"]; break;
+        case 8: break; // direct address
+        default: return -1;
+    }
+
+    return (base + instruction.displacement) & 0xffff;
+}
+
+// The memory operand is the destination for "op r/m, reg" (d = 0) and for every immediate to r/m
+bool isMemoryDestination(const X8086Instruction &instruction) {
+    return instruction.effectiveAddressForm != -1
+           && (instruction.operation == XImmediateToRegisterOrMemory || instruction.dBit == 0);
+}
+
+bool writesMemoryOperand(const X8086Instruction &instruction) {
+    return isMemoryDestination(instruction) && instruction.mnemonic != "cmp" && instruction.mnemonic != "test";
+}
+
+void decodeImmediateToAcc(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
                                  const std::string &operationType, ProgramOutput &programOutput, InstructionPointer &ip) {
+    instruction.mnemonic = operationType;
     instruction.wBit = sixteenBits.firstByte[0];
     if (instruction.wBit == 0) {
         instruction.destReg = "al";
@@ -345,8 +656,7 @@ void decodeImmediateToAcc(const TwoBytes &sixteenBits, std::ifstream &inputFile,
 
     // actually do the operation on register
     computeAddSubCmpAndSetZeroFlag(instruction, operationType, programOutput);
-    showAsHexa(ip.ip);
-    programOutput.instructionPrinter.emplace_back(operationType + " " + instruction.destReg + ", " + instruction.sourceReg);
+    //showAsHexa(ip.ip);
 }
 
 bool checkIfJump(const TwoBytes &inputBits) {
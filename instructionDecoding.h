@@ -5,21 +5,30 @@
 #ifndef HW1_INSTRUCTIONDECODING_H
 #define HW1_INSTRUCTIONDECODING_H
 
+#include <array>
 #include <iostream>
 #include <bitset>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "textArena.h"
+
+// Bump whenever the decoded output changes: it invalidates the on-disk decode caches
+const int decoderVersion = 5;
+
 struct InstructionFlags {
     bool signFlag = false;
     bool zeroFlag = false;
 };
 
 struct ProgramOutput {
-    std::vector<std::string> instructionPrinter;
+    std::vector<std::string_view> instructionPrinter; // lines stored in instructionText
+    TextArena instructionText;
     std::unordered_map<std::string, int> registerValueMap;
     InstructionFlags flags;
     int instructionPointer;
+    std::string stopReason; // empty if the program ran to its end
 };
 
 struct TwoBytes {
@@ -45,6 +54,25 @@ enum OperationName {
     SubImmediateFromAccumulator,
     CmpRegisterMemoryAndRegister,
     CmpImmediateWithAccumulator,
+    // Decoded for the disassembly only, the IP simply moves past them
+    ArithmeticRegMemoryAndReg, // or, adc, sbb, and, xor, test, xchg
+    ArithmeticImmediateToAccumulator,
+    PushPopInstruction,
+    IncDecRegister,
+    XchgWithAccumulator,
+    ShiftRotateInstruction, // group 2: D0 to D3
+    Group3Instruction, // F6, F7: test, not, neg, mul, imul, div, idiv
+    Group45Instruction, // FE, FF: inc, dec, call, jmp, push
+    StringInstruction,
+    CallJumpReturn, // call, jmp, ret, int
+    SegmentRegisterMove,
+    LoadAddress, // lea, les, lds
+    MovAccumulatorMemory,
+    MovImmediateToMemory,
+    InputOutput,
+    NoOperandInstruction,
+    EscapeInstruction,
+    InstructionPrefix, // lock, rep, segment override: applies to the next instruction
     NotFound
 };
 
@@ -63,23 +91,48 @@ struct X8086Instruction {
      */
     int wBit{};
     int sBit{};
+    int jumpDisplacement{}; // signed 8-bit displacement, relative to the next instruction
+    std::string prefix; // "lock ", "rep " or "repne "
+    std::string mnemonic; // mov, add, jnz...
+    std::string operationSize; // "byte" or "word" when it can't be deduced from the registers
+    /*
+     * Memory operand, when mod is 00, 01 or 10
+     * 0 to 7 -> r/m field ([bx+si] ... [bx]), 8 -> direct address, -1 -> no memory operand
+     */
+    int effectiveAddressForm = -1;
+    int displacement{}; // signed, or the address itself for a direct address
+    int effectiveAddress = -1; // computed right before execution
     std::string sourceReg;
     std::string destReg;
     OperationMod operationMod{};
 };
 
+struct DecodedInstruction {
+    int address = 0;
+    int size = 0; // in bytes
+    X8086Instruction instruction;
+};
+
 struct InstructionPointer {
     int ip = 0;
 };
 
-void decodeJumpInstruction(X8086Instruction &instruction, const TwoBytes &sixteenBits, ProgramOutput &programOutput, InstructionPointer &ip);
-void decodeImmediateInstruction(const TwoBytes &sixteenBits, std::ifstream &inputFile, X8086Instruction &instruction, ProgramOutput &programOutput, InstructionPointer &ip);
+OperationName getOperation(const TwoBytes &inputBits);
+void executeOperation(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction,
+                      ProgramOutput &programOutput, InstructionPointer &ip);
+bool decodeJumpInstruction(X8086Instruction &instruction, const TwoBytes &sixteenBits, ProgramOutput &programOutput, InstructionPointer &ip);
+bool checkJumpCondition(const std::string &jumpName, ProgramOutput &programOutput);
+void decodeImmediateInstruction(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, ProgramOutput &programOutput, InstructionPointer &ip);
 int getModAndDecodeExtraBytes(const TwoBytes &inputBits, X8086Instruction &instruction);
-void outputImmediateToReg(const TwoBytes &sixteenBits, std::ifstream &inputFile, X8086Instruction &instruction, const std::string &instructionType, ProgramOutput &programOutput, InstructionPointer &ip);
-void outputRegToReg(const TwoBytes &sixteenBits, std::ifstream &inputFile, X8086Instruction &instruction, const std::string& instructionType, ProgramOutput &programOutput, InstructionPointer &ip);
+void outputImmediateToReg(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, const std::string &instructionType, ProgramOutput &programOutput, InstructionPointer &ip);
+void outputRegToReg(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, const std::string& instructionType, ProgramOutput &programOutput, InstructionPointer &ip);
 bool decodeImmediateToRegInstruction(const TwoBytes &inputBits, X8086Instruction &instruction);
+void decodeEffectiveAddress(X8086Instruction &instruction, const std::bitset<3> &rmField, const std::string &byteDisplacement);
+int computeEffectiveAddress(const X8086Instruction &instruction, std::unordered_map<std::string, int> &registerValueMap);
+bool isMemoryDestination(const X8086Instruction &instruction);
+bool writesMemoryOperand(const X8086Instruction &instruction);
 void decodeRegToRegMovInstruction(const TwoBytes &inputBits, X8086Instruction &instruction, const std::string& byteDisplacement);
-void decodeImmediateToAcc(const TwoBytes &sixteenBits, std::ifstream &inputFile, X8086Instruction &instruction, const std::string &operationType, ProgramOutput &programOutput, InstructionPointer &ip);
+void decodeImmediateToAcc(const TwoBytes &sixteenBits, std::istream &inputFile, X8086Instruction &instruction, const std::string &operationType, ProgramOutput &programOutput, InstructionPointer &ip);
 bool checkIfJump(const TwoBytes &inputBits);
 bool checkIfImmediateMov(const TwoBytes &inputBits);
 void computeAddSubCmpAndSetZeroFlag(const X8086Instruction &instruction, const std::string &instructionType,
@@ -87,6 +140,9 @@ void computeAddSubCmpAndSetZeroFlag(const X8086Instruction &instruction, const s
 void checkZeroFlag(ProgramOutput &programOutput, int newValue);
 void computeDirectAddSubCmpAndSetZeroFlag(const X8086Instruction &instruction, const std::string &instructionType,
                                           ProgramOutput &programOutput);
+int getInstructionTextPieces(const X8086Instruction &instruction, std::array<std::string_view, 8> &pieces);
+std::string formatInstruction(const X8086Instruction &instruction);
+std::string_view formatInstruction(const X8086Instruction &instruction, TextArena &arena);
 void showAsHexa(int intValue);
 
 #endif //HW1_INSTRUCTIONDECODING_H
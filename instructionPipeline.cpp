@@ -0,0 +1,55 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include <cstring>
+
+#include "instructionPipeline.h"
+
+template <size_t N>
+void copyField(char (&field)[N], const std::string &value) {
+    size_t length = std::min(value.size(), N - 1);
+    std::memcpy(field, value.data(), length);
+    field[length] = '\0';
+}
+
+InstructionRecord makeInstructionRecord(int address, const X8086Instruction &instruction) {
+    InstructionRecord record;
+    record.address = address;
+    copyField(record.prefix, instruction.prefix);
+    copyField(record.mnemonic, instruction.mnemonic);
+    copyField(record.operationSize, instruction.operationSize);
+    copyField(record.destReg, instruction.destReg);
+    copyField(record.sourceReg, instruction.sourceReg);
+
+    return record;
+}
+
+X8086Instruction getInstructionFromRecord(const InstructionRecord &record) {
+    X8086Instruction instruction{};
+    instruction.prefix = record.prefix;
+    instruction.mnemonic = record.mnemonic;
+    instruction.operationSize = record.operationSize;
+    instruction.destReg = record.destReg;
+    instruction.sourceReg = record.sourceReg;
+
+    return instruction;
+}
+
+// Consumer side: formats the records and writes them in large chunks, until the queue is closed
+void runFormatterStage(InstructionQueue &queue, std::ostream &output) {
+    std::string pending;
+    InstructionRecord record;
+
+    while (popBlocking(queue, record)) {
+        pending += formatInstruction(getInstructionFromRecord(record));
+        pending += '\n';
+        if (pending.size() >= 1 << 16) {
+            output.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+            pending.clear();
+        }
+    }
+
+    output.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+    output.flush();
+}
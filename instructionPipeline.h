@@ -0,0 +1,32 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_INSTRUCTIONPIPELINE_H
+#define HW1_INSTRUCTIONPIPELINE_H
+
+#include <iostream>
+
+#include "instructionDecoding.h"
+#include "spscQueue.h"
+
+/*
+ * Fixed-size copy of a decoded instruction, so it can go through a ring buffer without any allocation.
+ * Operands longer than the fields are truncated.
+ */
+struct InstructionRecord {
+    int address = 0;
+    char prefix[8]{};
+    char mnemonic[8]{};
+    char operationSize[8]{};
+    char destReg[24]{};
+    char sourceReg[24]{};
+};
+
+using InstructionQueue = SpscQueue<InstructionRecord, 1024>;
+
+InstructionRecord makeInstructionRecord(int address, const X8086Instruction &instruction);
+X8086Instruction getInstructionFromRecord(const InstructionRecord &record);
+void runFormatterStage(InstructionQueue &queue, std::ostream &output);
+
+#endif //HW1_INSTRUCTIONPIPELINE_H
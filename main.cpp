@@ -2,60 +2,99 @@
 #include <fstream>
 #include <string>
 #include <bitset>
+#include <memory>
+#include <set>
+#include <thread>
 
 #include "instructionDecoding.h"
 #include "byteReader.h"
 #include "registerState.h"
+#include "instructionCache.h"
+#include "cppEmitter.h"
+#include "controlFlowGraph.h"
+#include "debugHooks.h"
+#include "samplingProfiler.h"
+#include "memoryTrace.h"
+#include "instructionPipeline.h"
+#include "streamReader.h"
+#include "decodeCache.h"
+#include "registerTrace.h"
+#include "decodeBench.h"
+#include "regressionHarness.h"
 
 
-OperationName getOperation(const TwoBytes &inputBits) {
-    // MOV
-    if (checkSixBitsInRegister(inputBits, std::bitset<6>(std::string("100010"))))
-        return MovRegisterToRegister;
-    if (checkIfImmediateMov(inputBits))
-        return MovImmediateToRegister;
-
-    // ADD
-    if (checkSixBitsInRegister(inputBits, std::bitset<6>(std::string("000000"))))
-        return AddRegisterToRegister;
-    if (checkSevenBitsInRegister(inputBits, std::bitset<7>(std::string("0000010"))))
-        return AddImmediateToAccumulator;
+void addBinaryToStringVector(std::vector<std::string>& outputVector, const TwoBytes& twoBytes) {
+    std::string firstByteStr = twoBytes.firstByte.to_string();
+    std::string secondByteStr = twoBytes.secondByte.to_string();
 
-    // SUB
-    if (checkSixBitsInRegister(inputBits, std::bitset<6>(std::string("001010"))))
-        return SubRegMemoryAndRegToEither;
-    if (checkSevenBitsInRegister(inputBits, std::bitset<7>(std::string("0010110"))))
-        return SubImmediateFromAccumulator;
+    std::string combined = firstByteStr + " " + secondByteStr;
 
-    // CMP
-    if (checkSixBitsInRegister(inputBits, std::bitset<6>(std::string("001110"))))
-        return CmpRegisterMemoryAndRegister;
-    if (checkSevenBitsInRegister(inputBits, std::bitset<7>(std::string("0011110"))))
-        return CmpImmediateWithAccumulator;
+    outputVector.push_back(combined);
+}
 
-    // Common for add, sub, cmp
-    if (checkSixBitsInRegister(inputBits, std::bitset<6>(std::string("100000"))))
-        return XImmediateToRegisterOrMemory; // need to check second byte -> could be add, sub, cmp
+bool readInstructionBytesAt(std::ifstream &inputFile, int address, bool littleEndian, TwoBytes &sixteenBits) {
+    uint16_t twoBytes;
+    std::bitset<16> binaryTwoBytes;
 
-    if (checkIfJump(inputBits))
-        return JumpInstruction;
+    if (inputFile.tellg() != address) {
+        inputFile.clear();
+        inputFile.seekg(address);
+    }
+    if (!readOpcodeBytes(inputFile, twoBytes))
+        return false;
 
-    return NotFound;
+    getSixteenBits(littleEndian, twoBytes, binaryTwoBytes, sixteenBits);
+    return true;
 }
 
-void addBinaryToStringVector(std::vector<std::string>& outputVector, const TwoBytes& twoBytes) {
-    std::string firstByteStr = twoBytes.firstByte.to_string();
-    std::string secondByteStr = twoBytes.secondByte.to_string();
+// Replays the instruction at 'address' through the interpreter on a copy of the state, and compares with the cache.
+void checkCachedExecution(std::ifstream &inputFile, bool littleEndian, int address, const ProgramOutput &stateBefore,
+                          const ProgramOutput &cachedState, int cachedNextAddress, InstructionCache &cache) {
+    ProgramOutput reference;
+    reference.registerValueMap = stateBefore.registerValueMap;
+    reference.flags = stateBefore.flags;
 
-    std::string combined = firstByteStr + " " + secondByteStr;
+    TwoBytes sixteenBits{};
+    X8086Instruction instruction{};
+    InstructionPointer ip{address};
+    if (readInstructionBytesAt(inputFile, address, littleEndian, sixteenBits))
+        executeOperation(sixteenBits, inputFile, instruction, reference, ip);
 
-    outputVector.push_back(combined);
+    if (reference.registerValueMap != cachedState.registerValueMap
+        || reference.flags.zeroFlag != cachedState.flags.zeroFlag
+        || reference.flags.signFlag != cachedState.flags.signFlag
+        || ip.ip != cachedNextAddress) {
+        cache.stats.differentialMismatches++;
+        std::cerr << "Differential mismatch at " << address << " (" << instruction.mnemonic << ")" << std::endl;
+    }
+}
+
+// Everything the execution loop feeds besides the guest state itself
+struct ExecutionEngine {
+    InstructionCache cache;
+    SamplingProfiler profiler;
+    MemoryTracer memoryTracer;
+    InstructionQueue *outputQueue = nullptr; // pipelined mode: the formatter thread prints the instructions
+    RegisterTrace registerTrace;
+    RunBudget runBudget;
+};
+
+void emitExecutedInstruction(ExecutionEngine &engine, ProgramOutput &programOutput, int address, const X8086Instruction &instruction) {
+    if (engine.registerTrace.enabled)
+        traceInstruction(engine.registerTrace, programOutput, instruction);
+    else if (engine.outputQueue != nullptr)
+        pushBlocking(*engine.outputQueue, makeInstructionRecord(address, instruction));
+    else
+        programOutput.instructionPrinter.push_back(formatInstruction(instruction, programOutput.instructionText));
 }
 
-ProgramOutput readBinFile(const std::string &listingXAssembledPath, bool littleEndian) {
+template <typename DebugPolicy>
+ProgramOutput readBinFile(const std::string &listingXAssembledPath, bool littleEndian, ExecutionEngine &engine,
+                          DebugPolicy &debugPolicy) {
     ProgramOutput programOutput;
+    InstructionCache &cache = engine.cache;
+    MemoryTracer &memoryTracer = engine.memoryTracer;
 
-    programOutput.instructionPrinter = std::vector<std::string>{};
     programOutput.registerValueMap =initializeRegisterValueMap();
 
     std::ifstream inputFile(listingXAssembledPath, std::ios::binary);
@@ -65,73 +104,429 @@ ProgramOutput readBinFile(const std::string &listingXAssembledPath, bool littleE
         return programOutput;
     }
 
-    uint16_t twoBytes;
-    std::bitset<16> binaryTwoBytes;
     TwoBytes sixteenBits{};
     InstructionPointer ip{};
+    if (engine.registerTrace.enabled)
+        initializeRegisterTrace(engine.registerTrace, programOutput, std::cout);
+    long long instructionCountdown = startRunBudget(engine.runBudget);
 
-    while (inputFile.read(reinterpret_cast<char*>(&twoBytes), sizeof(twoBytes))) {
-        X8086Instruction instruction{};
+    while (true) {
+        int instructionAddress = ip.ip;
 
-        sixteenBits = getSixteenBits(littleEndian, twoBytes, binaryTwoBytes, sixteenBits);
-        instruction.operation = getOperation(sixteenBits);
-        //addBinaryToStringVector(programOutput.instructionPrinter, sixteenBits); // debugging
-        //std::cout << sixteenBits.firstByte << " " << sixteenBits.secondByte << std::endl;
-
-        switch (instruction.operation) {
-            case MovRegisterToRegister:
-                outputRegToReg(sixteenBits, inputFile, instruction, "mov", programOutput, ip);
-                break;
-            case AddRegisterToRegister:
-                outputRegToReg(sixteenBits, inputFile, instruction, "add", programOutput, ip);
-                break;
-            case SubRegMemoryAndRegToEither:
-                outputRegToReg(sixteenBits, inputFile, instruction, "sub", programOutput, ip);
-                break;
-            case CmpRegisterMemoryAndRegister:
-                outputRegToReg(sixteenBits, inputFile, instruction, "cmp", programOutput, ip);
-                break;
-            case MovImmediateToRegister:
-                outputImmediateToReg(sixteenBits, inputFile, instruction, "mov", programOutput, ip);
-                break;
-            case AddImmediateToAccumulator:
-                decodeImmediateToAcc(sixteenBits, inputFile, instruction, "add", programOutput, ip);
-                break;
-            case SubImmediateFromAccumulator:
-                decodeImmediateToAcc(sixteenBits, inputFile, instruction, "sub", programOutput, ip);
+        if constexpr (DebugPolicy::enabled) {
+            if (checkBreakpoint(debugPolicy, instructionAddress)) {
+                programOutput.stopReason = "Breakpoint : " + std::to_string(instructionAddress);
                 break;
-            case CmpImmediateWithAccumulator:
-                decodeImmediateToAcc(sixteenBits, inputFile, instruction, "cmp", programOutput, ip);
-                break;
-            case JumpInstruction:
-                decodeJumpInstruction(instruction, sixteenBits, programOutput, ip);
+            }
+        }
+
+        bool endsBlock;
+        int storeAddress = -1;
+        int storeWidth = 0;
+        // Hot path: already decoded, no need to touch the file
+        if (const CachedInstruction *cached = findCachedInstruction(cache, instructionAddress)) {
+            cache.stats.cacheHits++;
+            endsBlock = cached->instruction.operation == JumpInstruction;
+            if (cached->instruction.effectiveAddressForm != -1) {
+                int effectiveAddress = computeEffectiveAddress(cached->instruction, programOutput.registerValueMap);
+                if (memoryTracer.enabled)
+                    traceMemoryOperand(memoryTracer, instructionAddress, effectiveAddress, cached->instruction);
+                if (writesMemoryOperand(cached->instruction)) {
+                    storeAddress = effectiveAddress;
+                    storeWidth = cached->instruction.wBit == 1 ? 2 : 1;
+                }
+            }
+
+            if (!cache.differential) {
+                ip.ip = executeCachedInstruction(*cached, instructionAddress, programOutput);
+            } else {
+                ProgramOutput stateBefore;
+                stateBefore.registerValueMap = programOutput.registerValueMap;
+                stateBefore.flags = programOutput.flags;
+                ip.ip = executeCachedInstruction(*cached, instructionAddress, programOutput);
+                checkCachedExecution(inputFile, littleEndian, instructionAddress, stateBefore, programOutput, ip.ip, cache);
+            }
+            sampleInstruction(engine.profiler, instructionAddress, cached->instruction);
+            emitExecutedInstruction(engine, programOutput, instructionAddress, cached->instruction);
+        } else {
+            if (!readInstructionBytesAt(inputFile, instructionAddress, littleEndian, sixteenBits))
                 break;
-            case XImmediateToRegisterOrMemory:
-                decodeImmediateInstruction(sixteenBits, inputFile, instruction, programOutput, ip);
+
+            X8086Instruction instruction{};
+            executeOperation(sixteenBits, inputFile, instruction, programOutput, ip);
+            if (!inputFile)
+                break; // last instruction is truncated
+
+            endsBlock = instruction.operation == JumpInstruction;
+            int size = static_cast<int>(inputFile.tellg()) - instructionAddress;
+            recordInterpretedInstruction(cache, instructionAddress, size, instruction);
+            if (instruction.operation != NotFound)
+                sampleInstruction(engine.profiler, instructionAddress, instruction);
+            if (memoryTracer.enabled && instruction.effectiveAddressForm != -1)
+                traceMemoryOperand(memoryTracer, instructionAddress, instruction.effectiveAddress, instruction);
+            if (instruction.operation != NotFound)
+                emitExecutedInstruction(engine, programOutput, instructionAddress, instruction);
+            if (writesMemoryOperand(instruction)) {
+                storeAddress = instruction.effectiveAddress;
+                storeWidth = instruction.wBit == 1 ? 2 : 1;
+            }
+        }
+        // After the cached path is done with its entry: the store may invalidate this very instruction
+        if (storeAddress != -1)
+            notifyGuestStore(cache, storeAddress, storeWidth);
+
+        --instructionCountdown;
+        if (endsBlock && checkRunBudget(engine.runBudget, instructionCountdown, programOutput.stopReason))
+            break;
+
+        if constexpr (DebugPolicy::enabled) {
+            if (checkRegisterWatchpoints(debugPolicy, programOutput, programOutput.stopReason))
                 break;
-            default:
-                std::cerr << "Operation was not found : " << sixteenBits.firstByte << " " << sixteenBits.secondByte << std::endl;
+            if (storeAddress != -1 && checkMemoryWatchpoints(debugPolicy, storeAddress, storeWidth, programOutput.stopReason))
                 break;
         }
     }
 
     inputFile.close();
+    if (memoryTracer.enabled)
+        flushMemoryTrace(memoryTracer);
+    if (engine.registerTrace.enabled)
+        flushRegisterTrace(engine.registerTrace);
 
     programOutput.instructionPointer = ip.ip;
 
     return programOutput;
 }
 
+/*
+ * Bounded-memory mode for stdin and pipes: each instruction is written as soon as it is executed and never stored.
+ * A pipe can't seek, so jumps are evaluated (flags, cx) but the stream is always read linearly.
+ */
+ProgramOutput streamBinFile(std::istream &input, bool littleEndian, std::ostream &output) {
+    ProgramOutput programOutput;
+    programOutput.registerValueMap = initializeRegisterValueMap();
+
+    uint16_t twoBytes;
+    std::bitset<16> binaryTwoBytes;
+    TwoBytes sixteenBits{};
+    InstructionPointer ip{};
+
+    while (readOpcodeBytes(input, twoBytes)) {
+        X8086Instruction instruction{};
+        sixteenBits = getSixteenBits(littleEndian, twoBytes, binaryTwoBytes, sixteenBits);
+        executeOperation(sixteenBits, input, instruction, programOutput, ip);
+        if (!input)
+            break; // last instruction is truncated
+
+        if (instruction.operation != NotFound)
+            output << formatInstruction(instruction) << '\n';
+    }
+
+    programOutput.instructionPointer = ip.ip;
+
+    return programOutput;
+}
+
+// Linear sweep over the whole image: decodes every instruction once, without following jumps.
+std::vector<DecodedInstruction> sweepBinFile(const std::string &listingXAssembledPath, bool littleEndian) {
+    std::vector<DecodedInstruction> decodedInstructions;
+    ProgramOutput scratch; // execution side effects are discarded
+    scratch.registerValueMap = initializeRegisterValueMap();
+
+    std::ifstream inputFile(listingXAssembledPath, std::ios::binary);
+    if (!inputFile)
+    {
+        std::cerr << "Could not open file." << std::endl;
+        return decodedInstructions;
+    }
+
+    TwoBytes sixteenBits{};
+    int address = 0;
+    while (readInstructionBytesAt(inputFile, address, littleEndian, sixteenBits)) {
+        DecodedInstruction decoded;
+        decoded.address = address;
+        InstructionPointer ip{address};
+        executeOperation(sixteenBits, inputFile, decoded.instruction, scratch, ip);
+        if (!inputFile)
+            break; // last instruction is truncated
+
+        address = static_cast<int>(inputFile.tellg());
+        decoded.size = address - decoded.address;
+        if (decoded.instruction.operation != NotFound)
+            decodedInstructions.push_back(decoded);
+    }
+
+    return decodedInstructions;
+}
+
+// Decodes the instructions of the graph's blocks, in address order. Unlike the linear sweep,
+// jump targets are decoded from their own address, and data that no path runs into is never decoded.
+std::vector<DecodedInstruction> decodeBlockInstructions(const std::string &listingXAssembledPath, bool littleEndian,
+                                                        const ControlFlowGraph &graph) {
+    std::vector<DecodedInstruction> decodedInstructions;
+    std::set<int> addresses;
+    for (const auto &[start, block] : graph.blocks)
+        addresses.insert(block.instructionAddresses.begin(), block.instructionAddresses.end());
+
+    std::ifstream inputFile(listingXAssembledPath, std::ios::binary);
+    ProgramOutput scratch; // execution side effects are discarded
+    scratch.registerValueMap = initializeRegisterValueMap();
+    TwoBytes sixteenBits{};
+    for (int address : addresses) {
+        if (!readInstructionBytesAt(inputFile, address, littleEndian, sixteenBits))
+            break;
+
+        DecodedInstruction decoded;
+        decoded.address = address;
+        InstructionPointer ip{address};
+        executeOperation(sixteenBits, inputFile, decoded.instruction, scratch, ip);
+        if (!inputFile)
+            break; // last instruction is truncated
+
+        decoded.size = static_cast<int>(inputFile.tellg()) - address;
+        if (decoded.instruction.operation != NotFound)
+            decodedInstructions.push_back(decoded);
+    }
+
+    return decodedInstructions;
+}
+
+std::vector<DecodedInstruction> decodeReachableInstructions(const std::string &listingXAssembledPath, bool littleEndian,
+                                                            int threadCount) {
+    ControlFlowGraph graph = buildControlFlowGraph(loadBinaryImage(listingXAssembledPath), 0, threadCount);
+    return decodeBlockInstructions(listingXAssembledPath, littleEndian, graph);
+}
+
+// Linear sweep or reachable blocks, or their predecoded form from the cache directory when the image didn't change
+std::vector<DecodedInstruction> getDecodedInstructions(const std::string &listingXAssembledPath, bool littleEndian,
+                                                       const std::string &decodeCacheDirectory, DecodeCacheKind kind,
+                                                       int threadCount) {
+    auto decode = [&] {
+        return kind == ReachableBlocksDecode ? decodeReachableInstructions(listingXAssembledPath, littleEndian, threadCount)
+                                             : sweepBinFile(listingXAssembledPath, littleEndian);
+    };
+    if (decodeCacheDirectory.empty())
+        return decode();
+
+    std::vector<uint8_t> image = loadBinaryImage(listingXAssembledPath);
+    uint64_t contentHash = hashBytes(image.data(), image.size());
+    std::string cachePath = getDecodeCachePath(decodeCacheDirectory, contentHash, kind);
+
+    std::vector<DecodedInstruction> decodedInstructions;
+    if (loadDecodeCache(cachePath, contentHash, image.size(), decodedInstructions))
+        return decodedInstructions;
+
+    decodedInstructions = decode();
+    if (!writeDecodeCache(cachePath, contentHash, image.size(), decodedInstructions))
+        std::cerr << "Could not write decode cache " << cachePath << std::endl;
+
+    return decodedInstructions;
+}
+
 int main(int argc, char *argv[])
 {
     bool littleEndian = true;
     std::string assembledPath = argv[1];
+    ExecutionEngine engine;
+    InstructionCache &cache = engine.cache;
+    MemoryTracer &memoryTracer = engine.memoryTracer;
+    BreakpointPolicy breakpointPolicy;
+    int samplingPeriod = 0;
+    bool pipelined = false;
+    bool streaming = assembledPath == "-"; // stdin
+    std::string emitCppPath;
+    std::string decodeCacheDirectory;
+    bool disassemble = false;
+    std::string cfgFormat;
+    int threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    int benchInstructionCount = 0;
+    std::string regressionBaselinePath;
+    RegressionOptions regressionOptions;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--no-cache")
+            cache.hotThreshold = 0;
+        else if (argument == "--hot-threshold" && i + 1 < argc)
+            cache.hotThreshold = std::stoi(argv[++i]);
+        else if (argument == "--differential")
+            cache.differential = true;
+        else if (argument == "--emit-cpp" && i + 1 < argc)
+            emitCppPath = argv[++i];
+        else if (argument == "--decode-cache" && i + 1 < argc)
+            decodeCacheDirectory = argv[++i];
+        else if (argument == "--disassemble")
+            disassemble = true;
+        else if (argument == "--cfg")
+            cfgFormat = "text";
+        else if (argument == "--cfg-dot")
+            cfgFormat = "dot";
+        else if (argument == "--break" && i + 1 < argc) {
+            if (!addBreakpoint(breakpointPolicy, argv[++i]))
+                return 1;
+        } else if (argument == "--watch" && i + 1 < argc) {
+            if (!addRegisterWatchpoint(breakpointPolicy, argv[++i]))
+                return 1;
+        } else if (argument == "--watch-mem" && i + 1 < argc) {
+            if (!addMemoryWatchpoint(breakpointPolicy, argv[++i]))
+                return 1;
+        }
+        else if (argument == "--profile")
+            samplingPeriod = (i + 1 < argc && std::isdigit(argv[i + 1][0])) ? std::stoi(argv[++i]) : 1000;
+        else if (argument == "--cache-sim") {
+            CacheConfig cacheConfig;
+            if (!parseCacheConfig(i + 1 < argc && argv[i + 1][0] != '-' ? argv[++i] : "", cacheConfig))
+                return 1;
+            initializeMemoryTracer(memoryTracer, cacheConfig);
+        }
+        else if (argument == "--stream")
+            streaming = true;
+        else if (argument == "--trace")
+            engine.registerTrace.enabled = true;
+        else if (argument == "--pipeline")
+            pipelined = true;
+        else if (argument == "--max-instructions" && i + 1 < argc)
+            engine.runBudget.maxInstructions = std::stoll(argv[++i]);
+        else if (argument == "--timeout-ms" && i + 1 < argc)
+            engine.runBudget.timeoutMs = std::stoi(argv[++i]);
+        else if (argument == "--regress" && i + 1 < argc)
+            regressionBaselinePath = argv[++i];
+        else if (argument == "--repetitions" && i + 1 < argc)
+            regressionOptions.repetitions = std::stoi(argv[++i]);
+        else if (argument == "--tolerance" && i + 1 < argc)
+            regressionOptions.tolerance = std::stod(argv[++i]);
+        else if (argument == "--update-baseline")
+            regressionOptions.updateBaseline = true;
+        else if (argument == "--bench-decode")
+            benchInstructionCount = (i + 1 < argc && std::isdigit(argv[i + 1][0])) ? std::stoi(argv[++i]) : 200000;
+        else if (argument == "--threads" && i + 1 < argc)
+            threadCount = std::stoi(argv[++i]);
+        else
+            std::cerr << "Unknown argument : " << argument << std::endl;
+    }
+
+    // Streaming is a single decode pass over a buffer: no cache, debug loop, tracing or whole image to work on
+    if (streaming) {
+        std::vector<std::string> unsupported;
+        if (hasBreakpointsOrWatchpoints(breakpointPolicy))
+            unsupported.push_back("--break/--watch/--watch-mem");
+        if (engine.registerTrace.enabled)
+            unsupported.push_back("--trace");
+        if (memoryTracer.enabled)
+            unsupported.push_back("--cache-sim");
+        if (engine.runBudget.maxInstructions > 0 || engine.runBudget.timeoutMs > 0)
+            unsupported.push_back("--max-instructions/--timeout-ms");
+        if (samplingPeriod > 0)
+            unsupported.push_back("--profile");
+        if (pipelined)
+            unsupported.push_back("--pipeline");
+        if (cache.differential)
+            unsupported.push_back("--differential");
+        if (assembledPath == "-" && (!emitCppPath.empty() || disassemble || !cfgFormat.empty()))
+            unsupported.push_back("--emit-cpp/--disassemble/--cfg (they need a file, not stdin)");
+
+        if (!unsupported.empty()) {
+            std::cerr << "Not supported with --stream :";
+            for (const std::string &option : unsupported)
+                std::cerr << " " << option;
+            std::cerr << std::endl;
+            return 1;
+        }
+    }
+
+    // The path is the listings directory here
+    if (!regressionBaselinePath.empty()) {
+        auto runListing = [&](const std::string &listingPath) {
+            ExecutionEngine listingEngine;
+            listingEngine.cache.hotThreshold = cache.hotThreshold;
+            NoDebugPolicy noDebugPolicy;
+            return readBinFile(listingPath, littleEndian, listingEngine, noDebugPolicy);
+        };
+        return runRegressionHarness(assembledPath, regressionBaselinePath, regressionOptions, runListing, std::cout) ? 0 : 1;
+    }
+
+    if (benchInstructionCount > 0)
+        return runDecodeBenchmark(benchInstructionCount, std::cout) ? 0 : 1;
+
+    if (!emitCppPath.empty()) {
+        std::ofstream cppFile(emitCppPath);
+        std::vector<DecodedInstruction> decodedInstructions
+                = getDecodedInstructions(assembledPath, littleEndian, decodeCacheDirectory, ReachableBlocksDecode, threadCount);
+        if (decodedInstructions.empty()) // nothing decodable at the entry -> linear sweep
+            decodedInstructions = getDecodedInstructions(assembledPath, littleEndian, decodeCacheDirectory, LinearSweepDecode, threadCount);
+        emitCppSource(decodedInstructions, assembledPath, cppFile);
+        std::cout << "C++ source written to " << emitCppPath << std::endl;
+        return 0;
+    }
+
+    if (disassemble) {
+        for (const DecodedInstruction &decoded : getDecodedInstructions(assembledPath, littleEndian, decodeCacheDirectory, LinearSweepDecode, threadCount))
+            std::cout << formatInstruction(decoded.instruction) << '\n';
+        return 0;
+    }
+
+    if (!cfgFormat.empty()) {
+        ControlFlowGraph graph = buildControlFlowGraph(loadBinaryImage(assembledPath), 0, threadCount);
+        if (cfgFormat == "dot")
+            printControlFlowGraphDot(graph, std::cout);
+        else
+            printControlFlowGraph(graph, std::cout);
+        return 0;
+    }
+
+    initializeSamplingProfiler(engine.profiler, samplingPeriod);
 
-    ProgramOutput programOutput = readBinFile(assembledPath, littleEndian);
-    std::cout << "\n=== Instructions ==" << std::endl;
+    // The trace is formatted on this thread, next to the state it compares
+    if (engine.registerTrace.enabled && !streaming) {
+        pipelined = false;
+        std::cout << "\n=== Instructions ==" << std::endl;
+    }
 
-    for (const std::string& instruction : programOutput.instructionPrinter) {
-        std::cout << instruction << std::endl;
+    // Pipelined mode: this thread decodes and executes, a second one formats and prints while it runs
+    std::unique_ptr<InstructionQueue> outputQueue;
+    std::thread formatter;
+    if (pipelined) {
+        std::cout << "\n=== Instructions ==" << std::endl;
+        outputQueue = std::make_unique<InstructionQueue>();
+        engine.outputQueue = outputQueue.get();
+        formatter = std::thread(runFormatterStage, std::ref(*outputQueue), std::ref(std::cout));
+    }
+
+    ProgramOutput programOutput;
+    if (streaming) {
+        std::FILE *file = assembledPath == "-" ? stdin : std::fopen(assembledPath.c_str(), "rb");
+        if (file == nullptr) {
+            std::cerr << "Could not open file." << std::endl;
+            return 1;
+        }
+
+        std::cout << "\n=== Instructions ==" << std::endl;
+        FixedBufferStreamBuf streamBuf(file, &std::cout);
+        std::istream input(&streamBuf);
+        programOutput = streamBinFile(input, littleEndian, std::cout);
+        if (file != stdin)
+            std::fclose(file);
+    } else if (hasBreakpointsOrWatchpoints(breakpointPolicy)) {
+        programOutput = readBinFile(assembledPath, littleEndian, engine, breakpointPolicy);
+    } else {
+        NoDebugPolicy noDebugPolicy;
+        programOutput = readBinFile(assembledPath, littleEndian, engine, noDebugPolicy);
+    }
+
+    if (pipelined) {
+        closeQueue(*outputQueue);
+        formatter.join();
+    }
+
+    if (!programOutput.stopReason.empty())
+        std::cout << "\nStopped -> " << programOutput.stopReason << std::endl;
+
+    if (!pipelined && !streaming && !engine.registerTrace.enabled) {
+        std::cout << "\n=== Instructions ==" << std::endl;
+
+        for (std::string_view instruction : programOutput.instructionPrinter) {
+            std::cout << instruction << '\n';
+        }
     }
 
     std::cout << "\n=== Registers state ==" << std::endl;
@@ -140,4 +535,20 @@ int main(int argc, char *argv[])
     std::cout << "\n=== Flags ===" << std::endl << "Z -> " << programOutput.flags.zeroFlag << " | S -> " << programOutput.flags.signFlag << std::endl;
     std::cout << "\n=== IP ===" << std::endl;
     showAsHexa(programOutput.instructionPointer);
+
+    std::cout << "\n=== Instruction cache ===" << std::endl;
+    printInstructionCacheStats(cache);
+
+    if (memoryTracer.enabled) {
+        std::cout << "\n=== Data cache ===" << std::endl;
+        printCacheReport(memoryTracer.simulator);
+    }
+
+    if (samplingPeriod > 0) {
+        std::cout << "\n=== Profile ===" << std::endl;
+        ControlFlowGraph graph = buildControlFlowGraph(loadBinaryImage(assembledPath), 0, threadCount);
+        printProfile(engine.profiler, graph, decodeBlockInstructions(assembledPath, littleEndian, graph), 10);
+    }
+
+    return engine.runBudget.exhausted ? 2 : 0; // batch runs can tell a runaway guest from a normal end
 }
\ No newline at end of file
@@ -0,0 +1,178 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include <algorithm>
+#include <charconv>
+#include <iomanip>
+#include <sstream>
+
+#include "memoryTrace.h"
+#include "decodingHashMaps.h"
+
+// Empty field -> keeps the default, otherwise a whole positive number
+bool parsePositiveField(const std::string &field, int &value) {
+    if (field.empty())
+        return true;
+
+    int parsed = 0;
+    auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), parsed);
+    if (error != std::errc() || end != field.data() + field.size() || parsed <= 0)
+        return false;
+
+    value = parsed;
+    return true;
+}
+
+// description is "size,associativity,lineSize,lru|random", e.g. "8192,2,32,lru". Missing fields keep their default.
+bool parseCacheConfig(const std::string &description, CacheConfig &config) {
+    std::vector<std::string> fields;
+    std::stringstream stream(description);
+    for (std::string field; std::getline(stream, field, ',');)
+        fields.push_back(field);
+    fields.resize(std::max<size_t>(fields.size(), 4));
+
+    if (!parsePositiveField(fields[0], config.sizeBytes) || !parsePositiveField(fields[1], config.associativity)
+        || !parsePositiveField(fields[2], config.lineSize)) {
+        std::cerr << "Invalid cache config (size, associativity and line size must be positive numbers) : " << description << std::endl;
+        return false;
+    }
+    if ((config.lineSize & (config.lineSize - 1)) != 0) {
+        std::cerr << "Invalid cache config (line size must be a power of two) : " << description << std::endl;
+        return false;
+    }
+    if (config.sizeBytes / config.associativity < config.lineSize) {
+        std::cerr << "Invalid cache config (size is smaller than one set of " << config.associativity << " lines) : "
+                  << description << std::endl;
+        return false;
+    }
+    if (fields[3] == "random")
+        config.replacement = RandomReplacement;
+    else if (!fields[3].empty() && fields[3] != "lru") {
+        std::cerr << "Invalid cache config (replacement is lru or random) : " << description << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void initializeMemoryTracer(MemoryTracer &tracer, const CacheConfig &config) {
+    tracer.enabled = true;
+    tracer.count = 0;
+
+    CacheSimulator &simulator = tracer.simulator;
+    simulator.config = config;
+    simulator.setCount = std::max(1, config.sizeBytes / (config.lineSize * config.associativity));
+    simulator.lines.assign(simulator.setCount * config.associativity, CacheLine{});
+}
+
+void pushMemoryAccess(MemoryTracer &tracer, const MemoryAccess &access) {
+    tracer.buffer[tracer.count++] = access;
+    if (tracer.count == tracer.buffer.size())
+        flushMemoryTrace(tracer);
+}
+
+void traceMemoryOperand(MemoryTracer &tracer, int ip, int effectiveAddress, const X8086Instruction &instruction) {
+    MemoryAccess access{ip, effectiveAddress, instruction.wBit == 1 ? 2 : 1, false, instruction.effectiveAddressForm};
+
+    if (!isMemoryDestination(instruction) || instruction.mnemonic != "mov") // everything reads, except mov to memory
+        pushMemoryAccess(tracer, access);
+
+    if (writesMemoryOperand(instruction)) {
+        access.isWrite = true;
+        pushMemoryAccess(tracer, access);
+    }
+}
+
+bool simulateLineAccess(CacheSimulator &simulator, int lineAddress) {
+    int associativity = simulator.config.associativity;
+    int set = lineAddress % simulator.setCount;
+    int tag = lineAddress / simulator.setCount;
+    CacheLine *ways = &simulator.lines[set * associativity];
+    simulator.clock++;
+
+    for (int way = 0; way < associativity; ++way) {
+        if (ways[way].tag == tag) {
+            ways[way].lastUsed = simulator.clock;
+            return true;
+        }
+    }
+
+    // Miss: fill an invalid way first, otherwise evict
+    int victim = -1;
+    for (int way = 0; way < associativity && victim == -1; ++way)
+        if (ways[way].tag == -1)
+            victim = way;
+
+    if (victim == -1) {
+        if (simulator.config.replacement == RandomReplacement) {
+            victim = static_cast<int>(simulator.random() % associativity);
+        } else {
+            victim = 0;
+            for (int way = 1; way < associativity; ++way)
+                if (ways[way].lastUsed < ways[victim].lastUsed)
+                    victim = way;
+        }
+    }
+
+    ways[victim].tag = tag;
+    ways[victim].lastUsed = simulator.clock;
+    return false;
+}
+
+void flushMemoryTrace(MemoryTracer &tracer) {
+    CacheSimulator &simulator = tracer.simulator;
+    int lineSize = simulator.config.lineSize;
+
+    for (size_t i = 0; i < tracer.count; ++i) {
+        const MemoryAccess &access = tracer.buffer[i];
+
+        // A word access can straddle two lines: it only hits if both do
+        bool hit = true;
+        for (int line = access.address / lineSize; line <= (access.address + access.size - 1) / lineSize; ++line)
+            hit = simulateLineAccess(simulator, line) && hit;
+
+        CacheStats &perIp = simulator.statsPerIp[access.ip];
+        CacheStats &perForm = simulator.statsPerForm[access.effectiveAddressForm];
+        (hit ? simulator.total.hits : simulator.total.misses)++;
+        (hit ? perIp.hits : perIp.misses)++;
+        (hit ? perForm.hits : perForm.misses)++;
+    }
+
+    tracer.count = 0;
+}
+
+void printCacheStatsLine(const std::string &name, const CacheStats &stats) {
+    long long accesses = stats.hits + stats.misses;
+    std::cout << std::setfill(' ') << std::left << std::setw(10) << name << std::right << std::setw(8) << accesses << " accesses  "
+              << std::fixed << std::setprecision(1) << std::setw(5)
+              << (accesses == 0 ? 0.0 : 100.0 * static_cast<double>(stats.hits) / static_cast<double>(accesses))
+              << "% hits" << std::endl;
+}
+
+void printCacheReport(const CacheSimulator &simulator) {
+    const CacheConfig &config = simulator.config;
+    std::cout << config.sizeBytes << " bytes, " << config.associativity << "-way, " << config.lineSize << " bytes lines, "
+              << (config.replacement == LeastRecentlyUsed ? "LRU" : "random") << std::endl;
+    printCacheStatsLine("total", simulator.total);
+
+    std::cout << "-- Per effective address --" << std::endl;
+    auto formNames = getHashEffAddCalculationFieldEncoding(MemoryModeNoDisplacement, "");
+    for (int form = 0; form < 9; ++form) {
+        if (simulator.statsPerForm[form].hits + simulator.statsPerForm[form].misses == 0)
+            continue;
+        printCacheStatsLine(form == 8 ? "[direct]" : formNames[std::bitset<3>(form)], simulator.statsPerForm[form]);
+    }
+
+    std::cout << "-- Per instruction --" << std::endl;
+    std::vector<int> addresses;
+    for (const auto &[ip, stats] : simulator.statsPerIp)
+        addresses.push_back(ip);
+    std::sort(addresses.begin(), addresses.end());
+
+    for (int ip : addresses) {
+        std::ostringstream name;
+        name << "0x" << std::hex << std::setfill('0') << std::setw(4) << ip;
+        printCacheStatsLine(name.str(), simulator.statsPerIp.at(ip));
+    }
+}
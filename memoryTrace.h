@@ -0,0 +1,74 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_MEMORYTRACE_H
+#define HW1_MEMORYTRACE_H
+
+#include <array>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "instructionDecoding.h"
+
+enum CacheReplacement {
+    LeastRecentlyUsed,
+    RandomReplacement
+};
+
+struct CacheConfig {
+    int sizeBytes = 4096;
+    int associativity = 4;
+    int lineSize = 64;
+    CacheReplacement replacement = LeastRecentlyUsed;
+};
+
+struct MemoryAccess {
+    int ip;
+    int address;
+    int size; // 1 or 2 bytes
+    bool isWrite;
+    int effectiveAddressForm; // see X8086Instruction
+};
+
+struct CacheLine {
+    int tag = -1; // -1 -> invalid
+    long long lastUsed = 0;
+};
+
+struct CacheStats {
+    long long hits = 0;
+    long long misses = 0;
+};
+
+struct CacheSimulator {
+    CacheConfig config;
+    int setCount = 0;
+    std::vector<CacheLine> lines; // setCount * associativity
+    long long clock = 0;
+    std::mt19937 random;
+    CacheStats total;
+    std::unordered_map<int, CacheStats> statsPerIp;
+    std::array<CacheStats, 9> statsPerForm; // indexed by effectiveAddressForm
+};
+
+/*
+ * Accesses are batched and only handed to the simulator when the buffer is full (or at the end of the run),
+ * so the execution loop only pays for a store into an array.
+ */
+struct MemoryTracer {
+    bool enabled = false;
+    std::array<MemoryAccess, 4096> buffer;
+    size_t count = 0;
+    CacheSimulator simulator;
+};
+
+bool parseCacheConfig(const std::string &description, CacheConfig &config);
+void initializeMemoryTracer(MemoryTracer &tracer, const CacheConfig &config);
+void traceMemoryOperand(MemoryTracer &tracer, int ip, int effectiveAddress, const X8086Instruction &instruction);
+void flushMemoryTrace(MemoryTracer &tracer);
+void printCacheReport(const CacheSimulator &simulator);
+
+#endif //HW1_MEMORYTRACE_H
@@ -22,12 +22,14 @@ std::unordered_map<std::string, int> initializeRegisterValueMap() {
 }
 
 void printRegisterValueMap(const std::unordered_map<std::string, int> &registerValueMap) {
-    for (const auto &pair : registerValueMap) {
+    // Fixed order, so two dumps can be diffed
+    for (const char *registerName : {"ax", "bx", "cx", "dx", "sp", "bp", "si", "di"}) {
+        int value = registerValueMap.at(registerName);
         // Left-align the register name and set a minimum width
-        std::cout << std::left << std::setw(6) << pair.first << ": 0x"
-                  << std::hex << std::setfill('0') << std::setw(4) << pair.second
+        std::cout << std::left << std::setw(6) << registerName << ": 0x"
+                  << std::right << std::hex << std::setfill('0') << std::setw(4) << value
                   // Reset fill character for decimal output
-                  << std::setfill(' ') << " (" << std::dec << pair.second << ")" << std::endl;
+                  << std::setfill(' ') << " (" << std::dec << value << ")" << std::endl;
     }
 }
 
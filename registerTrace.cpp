@@ -0,0 +1,109 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include <charconv>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+#include "registerTrace.h"
+
+const std::array<const char *, traceRegisterCount> traceRegisterNames = {"ax", "cx", "dx", "bx", "sp", "bp", "si", "di"};
+
+// 8-bit halves count as a write to the whole register
+const std::unordered_map<std::string, int> traceRegisterBits = {
+        {"ax", 1 << 0}, {"al", 1 << 0}, {"ah", 1 << 0},
+        {"cx", 1 << 1}, {"cl", 1 << 1}, {"ch", 1 << 1},
+        {"dx", 1 << 2}, {"dl", 1 << 2}, {"dh", 1 << 2},
+        {"bx", 1 << 3}, {"bl", 1 << 3}, {"bh", 1 << 3},
+        {"sp", 1 << 4},
+        {"bp", 1 << 5},
+        {"si", 1 << 6},
+        {"di", 1 << 7}
+};
+
+const size_t traceBufferSize = 1 << 16;
+
+void initializeRegisterTrace(RegisterTrace &trace, const ProgramOutput &programOutput, std::ostream &output) {
+    trace.enabled = true;
+    trace.output = &output;
+    trace.previousFlags = programOutput.flags;
+    trace.buffer.reserve(traceBufferSize + 256);
+    for (int i = 0; i < traceRegisterCount; ++i)
+        trace.previousValues[i] = programOutput.registerValueMap.at(traceRegisterNames[i]);
+}
+
+int getWrittenRegisterMask(const X8086Instruction &instruction) {
+    if (instruction.operation == JumpInstruction)
+        return instruction.mnemonic.starts_with("loop") ? 1 << 1 : 0;
+    if (instruction.mnemonic == "cmp")
+        return 0;
+
+    auto iterator = traceRegisterBits.find(instruction.destReg);
+    return iterator != traceRegisterBits.end() ? iterator->second : 0;
+}
+
+void appendText(std::vector<char> &buffer, std::string_view text) {
+    buffer.insert(buffer.end(), text.begin(), text.end());
+}
+
+void appendHexWord(std::vector<char> &buffer, int value) {
+    char digits[4];
+    auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value & 0xffff, 16);
+    size_t length = end - digits;
+
+    appendText(buffer, "0x");
+    buffer.insert(buffer.end(), 4 - length, '0');
+    buffer.insert(buffer.end(), digits, end);
+}
+
+void appendFlags(std::vector<char> &buffer, const InstructionFlags &flags) {
+    if (flags.zeroFlag)
+        buffer.push_back('Z');
+    if (flags.signFlag)
+        buffer.push_back('S');
+}
+
+void traceInstruction(RegisterTrace &trace, const ProgramOutput &programOutput, const X8086Instruction &instruction) {
+    std::vector<char> &buffer = trace.buffer;
+    appendText(buffer, formatInstruction(instruction));
+
+    bool hasDelta = false;
+    int writtenRegisters = getWrittenRegisterMask(instruction);
+    for (int i = 0; writtenRegisters != 0; ++i, writtenRegisters >>= 1) {
+        if ((writtenRegisters & 1) == 0)
+            continue;
+
+        int value = programOutput.registerValueMap.at(traceRegisterNames[i]);
+        if (value == trace.previousValues[i])
+            continue;
+
+        appendText(buffer, hasDelta ? " " : " ; ");
+        appendText(buffer, traceRegisterNames[i]);
+        buffer.push_back(':');
+        appendHexWord(buffer, trace.previousValues[i]);
+        appendText(buffer, "->");
+        appendHexWord(buffer, value);
+        trace.previousValues[i] = value;
+        hasDelta = true;
+    }
+
+    const InstructionFlags &flags = programOutput.flags;
+    if (flags.zeroFlag != trace.previousFlags.zeroFlag || flags.signFlag != trace.previousFlags.signFlag) {
+        appendText(buffer, hasDelta ? " flags:" : " ; flags:");
+        appendFlags(buffer, trace.previousFlags);
+        appendText(buffer, "->");
+        appendFlags(buffer, flags);
+        trace.previousFlags = flags;
+    }
+
+    buffer.push_back('\n');
+    if (buffer.size() >= traceBufferSize)
+        flushRegisterTrace(trace);
+}
+
+void flushRegisterTrace(RegisterTrace &trace) {
+    trace.output->write(trace.buffer.data(), static_cast<std::streamsize>(trace.buffer.size()));
+    trace.buffer.clear();
+}
@@ -0,0 +1,33 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_REGISTERTRACE_H
+#define HW1_REGISTERTRACE_H
+
+#include <array>
+#include <iostream>
+#include <vector>
+
+#include "instructionDecoding.h"
+
+/*
+ * Per-instruction trace : "mov cx, bx ; cx:0x0000->0x0003 flags:->Z"
+ * Only the registers the instruction can write (bitmask) are compared against their previous values.
+ */
+const int traceRegisterCount = 8;
+
+struct RegisterTrace {
+    bool enabled = false;
+    std::array<int, traceRegisterCount> previousValues{}; // ax, cx, dx, bx, sp, bp, si, di
+    InstructionFlags previousFlags;
+    std::vector<char> buffer; // written to output once it's full
+    std::ostream *output = &std::cout;
+};
+
+void initializeRegisterTrace(RegisterTrace &trace, const ProgramOutput &programOutput, std::ostream &output);
+int getWrittenRegisterMask(const X8086Instruction &instruction);
+void traceInstruction(RegisterTrace &trace, const ProgramOutput &programOutput, const X8086Instruction &instruction);
+void flushRegisterTrace(RegisterTrace &trace);
+
+#endif //HW1_REGISTERTRACE_H
@@ -0,0 +1,201 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <regex>
+#include <sstream>
+#include <vector>
+
+#include "regressionHarness.h"
+
+const double defaultTolerance = 0.25;
+// Timer and scheduler jitter: a few-microsecond listing can move by more than the tolerance on its own
+const double noiseFloorMicroseconds = 3.0;
+
+// "      bx: 0x0406 (1030)", "      ip: 0x000e (14)", "   flags: PZ" after "Final registers:"
+bool parseExpectedFinalState(const std::string &expectedOutputPath, ExpectedFinalState &expected) {
+    std::ifstream expectedOutput(expectedOutputPath);
+    std::string line;
+    bool inFinalRegisters = false;
+
+    while (std::getline(expectedOutput, line)) {
+        if (line.starts_with("Final registers:")) {
+            inFinalRegisters = true;
+            continue;
+        }
+        if (!inFinalRegisters)
+            continue;
+
+        std::istringstream fields(line);
+        std::string name, value;
+        if (!(fields >> name >> value))
+            continue;
+        name.pop_back(); // ':'
+
+        if (name == "flags") {
+            expected.zeroFlag = value.find('Z') != std::string::npos;
+            expected.signFlag = value.find('S') != std::string::npos;
+        } else if (name == "ip") {
+            expected.instructionPointer = std::stoi(value, nullptr, 16);
+        } else {
+            expected.registers[name] = std::stoi(value, nullptr, 16);
+        }
+    }
+
+    return inFinalRegisters;
+}
+
+std::vector<std::string> checkFinalState(const ProgramOutput &programOutput, const ExpectedFinalState &expected) {
+    std::vector<std::string> mismatches;
+    auto describe = [](const std::string &name, int actual, int wanted) {
+        std::ostringstream mismatch;
+        mismatch << name << " 0x" << std::hex << actual << " expected 0x" << wanted;
+        return mismatch.str();
+    };
+
+    for (const char *registerName : {"ax", "bx", "cx", "dx", "sp", "bp", "si", "di"}) {
+        int actual = programOutput.registerValueMap.at(registerName) & 0xffff;
+        int wanted = expected.registers.contains(registerName) ? expected.registers.at(registerName) : 0;
+        if (actual != wanted)
+            mismatches.push_back(describe(registerName, actual, wanted));
+    }
+    if (expected.instructionPointer != -1 && programOutput.instructionPointer != expected.instructionPointer)
+        mismatches.push_back(describe("ip", programOutput.instructionPointer, expected.instructionPointer));
+    if (programOutput.flags.zeroFlag != expected.zeroFlag)
+        mismatches.push_back(describe("Z", programOutput.flags.zeroFlag, expected.zeroFlag));
+    if (programOutput.flags.signFlag != expected.signFlag)
+        mismatches.push_back(describe("S", programOutput.flags.signFlag, expected.signFlag));
+
+    return mismatches;
+}
+
+// False when the file can't be read or holds no listing timing
+bool loadPerformanceBaseline(const std::string &baselinePath, std::map<std::string, double> &timings, double &tolerance) {
+    std::ifstream baselineFile(baselinePath);
+    if (!baselineFile)
+        return false;
+
+    std::stringstream content;
+    content << baselineFile.rdbuf();
+    std::string text = content.str();
+
+    // Flat scan of "name": number pairs, the nesting doesn't matter
+    std::regex pair("\"([^\"]+)\"\\s*:\\s*([0-9]+(?:\\.[0-9]+)?)");
+    for (auto match = std::sregex_iterator(text.begin(), text.end(), pair); match != std::sregex_iterator(); ++match) {
+        if ((*match)[1] == "tolerance")
+            tolerance = std::stod((*match)[2]);
+        else
+            timings[(*match)[1]] = std::stod((*match)[2]);
+    }
+
+    return !timings.empty();
+}
+
+void writePerformanceBaseline(const std::string &baselinePath, const std::map<std::string, double> &timings, double tolerance) {
+    std::ofstream baselineFile(baselinePath);
+    baselineFile << "{\n  \"tolerance\": " << tolerance << ",\n  \"listings\": {\n";
+
+    size_t written = 0;
+    for (const auto &[listing, microseconds] : timings) {
+        baselineFile << "    \"" << listing << "\": " << std::fixed << std::setprecision(2) << microseconds
+                     << (++written < timings.size() ? ",\n" : "\n");
+    }
+    baselineFile << "  }\n}\n";
+}
+
+// Best time of one run, in microseconds. Untimed warm-up runs first: the first listings shouldn't pay for cold caches.
+double timeListing(const std::string &listingPath, int repetitions, const ListingRunner &runListing) {
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < std::max(1, repetitions / 4); ++i)
+        runListing(listingPath);
+
+    for (int i = 0; i < repetitions; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        ProgramOutput programOutput = runListing(listingPath);
+        double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, microseconds);
+    }
+
+    return best;
+}
+
+bool runRegressionHarness(const std::string &listingsDirectory, const std::string &baselinePath,
+                          const RegressionOptions &options, const ListingRunner &runListing, std::ostream &output) {
+    if (options.repetitions < 1) {
+        std::cerr << "Invalid repetitions (at least 1) : " << options.repetitions << std::endl;
+        return false;
+    }
+    if (!std::filesystem::is_directory(listingsDirectory)) {
+        std::cerr << "Not a listings directory : " << listingsDirectory << std::endl;
+        return false;
+    }
+
+    double tolerance = defaultTolerance;
+    std::map<std::string, double> baseline;
+    if (!loadPerformanceBaseline(baselinePath, baseline, tolerance) && !options.updateBaseline) {
+        std::cerr << "Could not read a baseline from " << baselinePath << " (--update-baseline writes one)" << std::endl;
+        return false;
+    }
+    if (options.tolerance >= 0)
+        tolerance = options.tolerance;
+
+    // Assembled listings are the files without an extension
+    std::vector<std::filesystem::path> listings;
+    for (const auto &entry : std::filesystem::directory_iterator(listingsDirectory)) {
+        if (entry.is_regular_file() && !entry.path().has_extension())
+            listings.push_back(entry.path());
+    }
+    std::sort(listings.begin(), listings.end());
+
+    bool passed = true;
+    std::map<std::string, double> timings;
+    for (const std::filesystem::path &listing : listings) {
+        std::string name = listing.filename().string();
+        output << std::left << std::setw(36) << name << std::right;
+
+        ExpectedFinalState expected;
+        std::filesystem::path expectedOutputPath = listing;
+        expectedOutputPath.replace_extension(".txt");
+        if (parseExpectedFinalState(expectedOutputPath.string(), expected)) {
+            std::vector<std::string> mismatches = checkFinalState(runListing(listing.string()), expected);
+            output << (mismatches.empty() ? "state ok    " : "STATE FAIL  ");
+            for (const std::string &mismatch : mismatches)
+                output << mismatch << "; ";
+            passed &= mismatches.empty();
+        } else {
+            output << "no .txt     ";
+        }
+
+        double microseconds = timeListing(listing.string(), options.repetitions, runListing);
+        timings[name] = microseconds;
+        output << std::fixed << std::setprecision(2) << std::setw(10) << microseconds << " us";
+
+        if (auto iterator = baseline.find(name); iterator != baseline.end() && !options.updateBaseline) {
+            double change = microseconds / iterator->second - 1;
+            output << "  baseline " << std::setw(8) << iterator->second << " us  " << std::showpos
+                   << std::setprecision(1) << change * 100 << "%" << std::noshowpos;
+            if (change > tolerance && microseconds - iterator->second > noiseFloorMicroseconds) {
+                output << "  SLOWER";
+                passed = false;
+            }
+        } else if (!options.updateBaseline) {
+            output << "  NO BASELINE"; // a new listing has to be recorded, or it would never be gated
+            passed = false;
+        }
+        output << std::defaultfloat << std::setprecision(6) << std::endl;
+    }
+
+    if (options.updateBaseline) {
+        writePerformanceBaseline(baselinePath, timings, tolerance);
+        output << "Baseline written to " << baselinePath << std::endl;
+    }
+    output << (passed ? "PASSED" : "FAILED") << " (tolerance " << tolerance * 100 << "%)" << std::endl;
+
+    return passed;
+}
@@ -0,0 +1,45 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_REGRESSIONHARNESS_H
+#define HW1_REGRESSIONHARNESS_H
+
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include "instructionDecoding.h"
+
+/*
+ * Runs every assembled listing of a directory: the final state is checked against the "Final registers" section of
+ * its .txt file, and the best time over many repetitions against a baseline JSON ({"tolerance": 0.25,
+ * "listings": {"<listing>": <microseconds>, ...}}).
+ * Only the Z and S flags are simulated, so the other flags of the .txt files are ignored.
+ * The gate fails closed: an unreadable baseline, or a listing without a baseline entry, is a failure
+ * (run once with updateBaseline to record new listings).
+ */
+struct ExpectedFinalState {
+    std::unordered_map<std::string, int> registers; // registers that are not listed are 0
+    int instructionPointer = -1; // -1 -> not listed
+    bool zeroFlag = false;
+    bool signFlag = false;
+};
+
+struct RegressionOptions {
+    int repetitions = 1000;
+    double tolerance = -1; // relative slowdown allowed, -1 -> the one from the baseline file
+    bool updateBaseline = false;
+};
+
+using ListingRunner = std::function<ProgramOutput(const std::string &listingPath)>;
+
+bool parseExpectedFinalState(const std::string &expectedOutputPath, ExpectedFinalState &expected);
+bool loadPerformanceBaseline(const std::string &baselinePath, std::map<std::string, double> &timings, double &tolerance);
+void writePerformanceBaseline(const std::string &baselinePath, const std::map<std::string, double> &timings, double tolerance);
+bool runRegressionHarness(const std::string &listingsDirectory, const std::string &baselinePath,
+                          const RegressionOptions &options, const ListingRunner &runListing, std::ostream &output);
+
+#endif //HW1_REGRESSIONHARNESS_H
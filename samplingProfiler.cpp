@@ -0,0 +1,83 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <vector>
+
+#include "samplingProfiler.h"
+
+void initializeSamplingProfiler(SamplingProfiler &profiler, int samplingPeriod) {
+    profiler.samplingPeriod = samplingPeriod;
+    // When disabled, the countdown starts so high that it never reaches 0 in practice
+    profiler.countdown = samplingPeriod > 0 ? samplingPeriod : std::numeric_limits<int>::max();
+}
+
+void recordSample(SamplingProfiler &profiler, int address, const X8086Instruction &instruction) {
+    if (profiler.samplingPeriod <= 0) {
+        profiler.countdown = std::numeric_limits<int>::max();
+        return;
+    }
+
+    profiler.countdown = profiler.samplingPeriod;
+    profiler.totalSamples++;
+    if (profiler.samples[address]++ == 0)
+        profiler.sampledInstructions[address] = instruction;
+}
+
+std::vector<std::pair<int, long long>> getTopEntries(const std::unordered_map<int, long long> &histogram, int topCount) {
+    std::vector<std::pair<int, long long>> entries(histogram.begin(), histogram.end());
+    std::sort(entries.begin(), entries.end(), [](const auto &left, const auto &right) {
+        return left.second != right.second ? left.second > right.second : left.first < right.first;
+    });
+    if (static_cast<int>(entries.size()) > topCount)
+        entries.resize(topCount);
+
+    return entries;
+}
+
+void printSampleLine(int address, long long count, long long total) {
+    std::cout << std::right << "0x" << std::hex << std::setfill('0') << std::setw(4) << address << std::dec << std::setfill(' ')
+              << "  " << std::setw(8) << count << "  " << std::fixed << std::setprecision(1) << std::setw(5)
+              << 100.0 * static_cast<double>(count) / static_cast<double>(total) << "%";
+}
+
+void printProfile(const SamplingProfiler &profiler, const ControlFlowGraph &graph,
+                  const std::vector<DecodedInstruction> &blockInstructions, int topCount) {
+    std::cout << "Samples : " << profiler.totalSamples << " (every " << profiler.samplingPeriod << " instructions)" << std::endl;
+    if (profiler.totalSamples == 0)
+        return;
+
+    std::cout << "-- Hottest instructions --" << std::endl;
+    for (const auto &[address, count] : getTopEntries(profiler.samples, topCount)) {
+        printSampleLine(address, count, profiler.totalSamples);
+        std::cout << "  " << formatInstruction(profiler.sampledInstructions.at(address)) << std::endl;
+    }
+
+    std::unordered_map<int, long long> blockSamples;
+    for (const auto &[address, count] : profiler.samples) {
+        const BasicBlock *block = findBlockContaining(graph, address);
+        blockSamples[block != nullptr ? block->start : address] += count;
+    }
+
+    std::unordered_map<int, const X8086Instruction *> decodedAt;
+    for (const DecodedInstruction &decoded : blockInstructions)
+        decodedAt[decoded.address] = &decoded.instruction;
+
+    std::cout << "-- Hottest blocks --" << std::endl;
+    for (const auto &[start, count] : getTopEntries(blockSamples, topCount)) {
+        printSampleLine(start, count, profiler.totalSamples);
+        std::cout << std::endl;
+
+        auto block = graph.blocks.find(start);
+        if (block == graph.blocks.end())
+            continue;
+        for (int address : block->second.instructionAddresses) {
+            auto decoded = decodedAt.find(address);
+            std::cout << std::right << "    0x" << std::hex << std::setfill('0') << std::setw(4) << address << std::dec << std::setfill(' ')
+                      << "  " << (decoded != decodedAt.end() ? formatInstruction(*decoded->second) : "(not decoded)") << std::endl;
+        }
+    }
+}
@@ -0,0 +1,38 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_SAMPLINGPROFILER_H
+#define HW1_SAMPLINGPROFILER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "instructionDecoding.h"
+#include "controlFlowGraph.h"
+
+/*
+ * Statistical profiler: every 'samplingPeriod' simulated instructions, the guest IP goes into a histogram.
+ * Between two samples the only cost is a countdown decrement.
+ */
+struct SamplingProfiler {
+    int samplingPeriod = 0; // 0 -> disabled
+    int countdown = 0;
+    long long totalSamples = 0;
+    std::unordered_map<int, long long> samples; // guest IP -> number of samples
+    std::unordered_map<int, X8086Instruction> sampledInstructions; // guest IP -> instruction, for the report
+};
+
+void initializeSamplingProfiler(SamplingProfiler &profiler, int samplingPeriod);
+void recordSample(SamplingProfiler &profiler, int address, const X8086Instruction &instruction);
+// blockInstructions: the decoded instructions of the graph's blocks, for the disassembly of the hottest blocks
+void printProfile(const SamplingProfiler &profiler, const ControlFlowGraph &graph,
+                  const std::vector<DecodedInstruction> &blockInstructions, int topCount);
+
+inline void sampleInstruction(SamplingProfiler &profiler, int address, const X8086Instruction &instruction) {
+    if (--profiler.countdown == 0)
+        recordSample(profiler, address, instruction);
+}
+
+#endif //HW1_SAMPLINGPROFILER_H
@@ -0,0 +1,58 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_SPSCQUEUE_H
+#define HW1_SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+/*
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ * head/tail only grow; the slot is their value modulo Capacity (a power of two).
+ * A full queue makes the producer wait (backpressure), closing it lets the consumer drain what is left and stop.
+ */
+template <typename T, size_t Capacity>
+struct SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    std::array<T, Capacity> slots;
+    alignas(64) std::atomic<size_t> head{0}; // next slot to read, only written by the consumer
+    alignas(64) std::atomic<size_t> tail{0}; // next slot to write, only written by the producer
+    std::atomic<bool> closed{false};
+};
+
+template <typename T, size_t Capacity>
+void pushBlocking(SpscQueue<T, Capacity> &queue, const T &item) {
+    size_t tail = queue.tail.load(std::memory_order_relaxed);
+    while (tail - queue.head.load(std::memory_order_acquire) == Capacity)
+        std::this_thread::yield();
+
+    queue.slots[tail & (Capacity - 1)] = item;
+    queue.tail.store(tail + 1, std::memory_order_release);
+}
+
+// Returns false once the queue is closed and empty
+template <typename T, size_t Capacity>
+bool popBlocking(SpscQueue<T, Capacity> &queue, T &item) {
+    size_t head = queue.head.load(std::memory_order_relaxed);
+    while (queue.tail.load(std::memory_order_acquire) == head) {
+        if (queue.closed.load(std::memory_order_acquire) && queue.tail.load(std::memory_order_acquire) == head)
+            return false;
+        std::this_thread::yield();
+    }
+
+    item = queue.slots[head & (Capacity - 1)];
+    queue.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, size_t Capacity>
+void closeQueue(SpscQueue<T, Capacity> &queue) {
+    queue.closed.store(true, std::memory_order_release);
+}
+
+#endif //HW1_SPSCQUEUE_H
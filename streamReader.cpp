@@ -0,0 +1,36 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include "streamReader.h"
+
+FixedBufferStreamBuf::FixedBufferStreamBuf(std::FILE *file, std::ostream *flushBeforeRefill)
+        : file(file), flushBeforeRefill(flushBeforeRefill), buffer(bufferSize) {
+    std::setvbuf(file, nullptr, _IONBF, 0); // this class is the only buffer
+    setg(buffer.data(), buffer.data(), buffer.data());
+}
+
+FixedBufferStreamBuf::int_type FixedBufferStreamBuf::underflow() {
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    if (flushBeforeRefill != nullptr)
+        flushBeforeRefill->flush();
+
+    consumedBeforeBuffer += egptr() - eback();
+    size_t bytesRead = std::fread(buffer.data(), 1, buffer.size(), file);
+    setg(buffer.data(), buffer.data(), buffer.data() + bytesRead);
+
+    if (bytesRead == 0)
+        return traits_type::eof();
+    return traits_type::to_int_type(*gptr());
+}
+
+// Only reports the current position (tellg), a pipe can't seek
+FixedBufferStreamBuf::pos_type FixedBufferStreamBuf::seekoff(off_type offset, std::ios_base::seekdir direction,
+                                                            std::ios_base::openmode mode) {
+    if (offset != 0 || direction != std::ios_base::cur || !(mode & std::ios_base::in))
+        return pos_type(off_type(-1));
+
+    return pos_type(consumedBeforeBuffer + (gptr() - eback()));
+}
@@ -0,0 +1,35 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_STREAMREADER_H
+#define HW1_STREAMREADER_H
+
+#include <cstdio>
+#include <iostream>
+#include <streambuf>
+#include <vector>
+
+/*
+ * Input buffer of a fixed size, refilled from a file or pipe (stdin) as the decoder consumes it.
+ * Instructions that straddle two refills are handled by std::istream::read, which simply asks for the next refill.
+ * Before blocking on a refill, 'flushBeforeRefill' is flushed, so everything decoded so far is visible right away.
+ */
+class FixedBufferStreamBuf : public std::streambuf {
+public:
+    static constexpr size_t bufferSize = 1 << 16;
+
+    explicit FixedBufferStreamBuf(std::FILE *file, std::ostream *flushBeforeRefill = nullptr);
+
+protected:
+    int_type underflow() override;
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode) override;
+
+private:
+    std::FILE *file;
+    std::ostream *flushBeforeRefill;
+    std::vector<char> buffer;
+    long long consumedBeforeBuffer = 0; // bytes of the stream before the current buffer content
+};
+
+#endif //HW1_STREAMREADER_H
@@ -0,0 +1,30 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#include <algorithm>
+#include <cstring>
+
+#include "textArena.h"
+
+char *allocateText(TextArena &arena, size_t size) {
+    if (size > arena.remaining) {
+        size_t blockSize = std::max(size, textArenaBlockSize); // a longer line gets a block of its own
+        arena.blocks.push_back(std::make_unique_for_overwrite<char[]>(blockSize));
+        arena.cursor = arena.blocks.back().get();
+        arena.remaining = blockSize;
+    }
+
+    char *text = arena.cursor;
+    arena.cursor += size;
+    arena.remaining -= size;
+
+    return text;
+}
+
+std::string_view storeText(TextArena &arena, std::string_view text) {
+    char *storage = allocateText(arena, text.size());
+    std::memcpy(storage, text.data(), text.size());
+
+    return {storage, text.size()};
+}
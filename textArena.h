@@ -0,0 +1,27 @@
+//
+// Created by rob on 19/10/26.
+//
+
+#ifndef HW1_TEXTARENA_H
+#define HW1_TEXTARENA_H
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/*
+ * Monotonic storage for the disassembly text: lines are written one after the other in large blocks and handed out
+ * as string_views. Nothing is freed before the arena itself, which releases every block at once.
+ */
+const size_t textArenaBlockSize = 1 << 20;
+
+struct TextArena {
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char *cursor = nullptr;
+    size_t remaining = 0;
+};
+
+char *allocateText(TextArena &arena, size_t size);
+std::string_view storeText(TextArena &arena, std::string_view text);
+
+#endif //HW1_TEXTARENA_H